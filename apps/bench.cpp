@@ -0,0 +1,591 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <rasterizer/renderer.hpp>
+#include <rasterizer/pipeline.hpp>
+#include <rasterizer/shader.hpp>
+#include <rasterizer/primitives.hpp>
+#include <rasterizer/image.hpp>
+#include <rasterizer/texture.hpp>
+#include <rasterizer/compressed_texture.hpp>
+#include <rasterizer/compressed_depth.hpp>
+#include <rasterizer/thread_pool.hpp>
+#include <rasterizer/perf_counters.hpp>
+
+using namespace rasterizer;
+
+// Micro-benchmarks of the renderer's kernels
+// Every benchmark runs batches of operations, sized so that a batch takes at least --min-time,
+// and repeats them --repetitions times; the median time per operation is reported along with
+// the spread between repetitions
+
+namespace
+{
+
+	// Keeps the compiler from optimizing away computations whose result is unused
+	template <typename T>
+	void keep(T const & value)
+	{
+#if defined(__GNUC__)
+		asm volatile("" : : "r"(&value) : "memory");
+#else
+		static volatile char sink;
+		sink = *(char const volatile *)&value;
+#endif
+	}
+
+	struct settings
+	{
+		std::vector<std::string> filters;
+		int repetitions = 11;
+		double min_time = 0.02;
+		bool perf = false;
+	};
+
+	struct benchmark
+	{
+		std::string name;
+
+		// Things processed per operation (pixels, samples, triangles...) and bytes of
+		// memory traffic per operation, 0 if not meaningful
+		double items_per_op = 0.0;
+		double bytes_per_op = 0.0;
+
+		// Runs the given number of operations
+		std::function<void(std::uint64_t)> run;
+	};
+
+	bool selected(settings const & settings, std::string_view name)
+	{
+		if (settings.filters.empty())
+			return true;
+
+		for (auto const & filter : settings.filters)
+			if (name.find(filter) != std::string_view::npos)
+				return true;
+
+		return false;
+	}
+
+	void measure(settings const & settings, benchmark const & benchmark)
+	{
+		using clock = std::chrono::steady_clock;
+
+		auto time = [&](std::uint64_t count)
+		{
+			auto start = clock::now();
+			benchmark.run(count);
+			return std::chrono::duration<double>(clock::now() - start).count();
+		};
+
+		// Warm up caches & calibrate the batch size
+		std::uint64_t count = 1;
+		while (time(count) < settings.min_time && count < (std::uint64_t(1) << 40))
+			count *= 2;
+
+		std::vector<double> ns_per_op;
+		for (int i = 0; i < settings.repetitions; ++i)
+			ns_per_op.push_back(time(count) * 1e9 / count);
+
+		std::sort(ns_per_op.begin(), ns_per_op.end());
+
+		double median = ns_per_op[ns_per_op.size() / 2];
+
+		double mean = 0.0;
+		for (double value : ns_per_op)
+			mean += value;
+		mean /= ns_per_op.size();
+
+		double variance = 0.0;
+		for (double value : ns_per_op)
+			variance += (value - mean) * (value - mean);
+		double deviation = std::sqrt(variance / ns_per_op.size());
+
+		std::printf("%-44s %12.2f ns/op  min %12.2f  +-%5.1f%%", benchmark.name.c_str(), median, ns_per_op.front(), 100.0 * deviation / mean);
+
+		if (benchmark.items_per_op > 0.0)
+			std::printf("  %10.2f M/s", benchmark.items_per_op / median * 1e3);
+
+		if (benchmark.bytes_per_op > 0.0)
+			std::printf("  %8.2f GB/s", benchmark.bytes_per_op / median);
+
+		std::printf("\n");
+
+		// One more batch, to read hardware counters without slowing the timed ones down
+		if (settings.perf)
+		{
+			auto begin = read_perf_counters();
+			benchmark.run(count);
+			auto perf = read_perf_counters() - begin;
+
+			std::printf("%-44s", "");
+
+			if (perf.has(perf_counter::cycles))
+				std::printf(" %10.1f cycles/op", double(perf[perf_counter::cycles]) / count);
+			if (perf.has(perf_counter::cycles) && perf.has(perf_counter::instructions) && perf[perf_counter::cycles] > 0)
+				std::printf("  IPC %4.2f", double(perf[perf_counter::instructions]) / perf[perf_counter::cycles]);
+
+			for (auto counter : {perf_counter::llc_misses, perf_counter::branch_misses, perf_counter::dtlb_misses})
+				if (perf.has(counter))
+					std::printf("  %s/op %.3f", perf_counter_names[std::size_t(counter)], double(perf[counter]) / count);
+
+			std::printf("\n");
+		}
+
+		std::fflush(stdout);
+	}
+
+	// Triangles in clip space
+
+	std::vector<benchmark> clip_benchmarks()
+	{
+		struct clip_case
+		{
+			char const * name;
+			vector4f positions[3];
+		};
+
+		static clip_case const cases[] =
+		{
+			{"inside",           {{-0.5f, -0.5f, 0.f, 1.f}, {0.5f, -0.5f, 0.f, 1.f}, {0.f, 0.5f, 0.f, 1.f}}},
+			{"one behind near",  {{-0.5f, -0.5f, -2.f, 1.f}, {0.5f, -0.5f, 0.f, 1.f}, {0.f, 0.5f, 0.f, 1.f}}},
+			{"two behind near",  {{-0.5f, -0.5f, -2.f, 1.f}, {0.5f, -0.5f, -2.f, 1.f}, {0.f, 0.5f, 0.f, 1.f}}},
+			{"near and far",     {{-0.5f, -0.5f, -2.f, 1.f}, {0.5f, -0.5f, 2.f, 1.f}, {0.f, 0.5f, 0.f, 1.f}}},
+			{"outside",          {{-0.5f, -0.5f, -2.f, 1.f}, {0.5f, -0.5f, -2.f, 1.f}, {0.f, 0.5f, -2.f, 1.f}}},
+		};
+
+		std::vector<benchmark> result;
+
+		for (auto const & c : cases)
+		{
+			result.push_back({
+				.name = std::string("clip/") + c.name,
+				.items_per_op = 1.0,
+				.run = [&c](std::uint64_t count)
+				{
+					vertex vertices[12];
+					for (std::uint64_t i = 0; i < count; ++i)
+					{
+						for (int v = 0; v < 3; ++v)
+							vertices[v].position = c.positions[v];
+						keep(vertices);
+
+						auto end = clip_triangle(vertices, vertices + 3);
+						keep(end);
+					}
+				},
+			});
+		}
+
+		return result;
+	}
+
+	// Vertex fetch: every attribute the fixed-function vertex stage reads, for every vertex of
+	// a finely tessellated sphere, stored as floats or in compressed formats
+	std::vector<benchmark> attribute_benchmarks()
+	{
+		static mesh_data const sphere = make_sphere(256, 512);
+		static packed_mesh_data const packed_sphere = pack(sphere);
+
+		std::vector<benchmark> result;
+
+		for (bool packed : {false, true})
+		{
+			mesh const mesh = packed ? packed_sphere.view() : sphere.view();
+			auto vertex_count = std::uint32_t(sphere.positions.size());
+
+			std::uint32_t vertex_size = 0;
+			vertex_size += mesh.positions.stride;
+			vertex_size += mesh.normals.stride;
+			vertex_size += mesh.texcoords.stride;
+
+			result.push_back({
+				.name = packed ? "attribute/fetch packed" : "attribute/fetch float32",
+				.items_per_op = double(vertex_count),
+				.bytes_per_op = double(vertex_count) * vertex_size,
+				.run = [mesh, vertex_count](std::uint64_t count)
+				{
+					for (std::uint64_t i = 0; i < count; ++i)
+					{
+						for (std::uint32_t v = 0; v < vertex_count; ++v)
+						{
+							keep(mesh.positions[v]);
+							keep(mesh.normals[v]);
+							keep(mesh.texcoords[v]);
+						}
+					}
+				},
+			});
+		}
+
+		return result;
+	}
+
+	// Quad loop: grids of right triangles with legs of the given size in pixels,
+	// untextured and unlit, with a depth test
+
+	std::vector<benchmark> raster_benchmarks()
+	{
+		constexpr std::uint32_t size = 1024;
+
+		struct state
+		{
+			image<color4ub> color = image<color4ub>::allocate(size, size, {.layout = image_layout::tiled});
+			image<std::uint32_t> depth = image<std::uint32_t>::allocate(size, size, {.layout = image_layout::tiled});
+		};
+
+		static state state;
+
+		std::vector<benchmark> result;
+
+		for (std::uint32_t leg : {2u, 8u, 32u, 128u, 512u})
+		{
+			// As many triangles as fit, up to 1024 per draw, one per cell of a grid
+			std::uint32_t cells = std::min(size / leg, 32u);
+
+			auto positions = std::make_shared<std::vector<vector3f>>();
+			for (std::uint32_t y = 0; y < cells; ++y)
+			{
+				for (std::uint32_t x = 0; x < cells; ++x)
+				{
+					// Window to NDC, y pointing down
+					auto to_ndc = [](float x, float y){ return vector3f{2.f * x / size - 1.f, 1.f - 2.f * y / size, 0.f}; };
+
+					float x0 = x * leg + 0.25f;
+					float y0 = y * leg + 0.25f;
+					positions->push_back(to_ndc(x0, y0));
+					positions->push_back(to_ndc(x0 + leg, y0));
+					positions->push_back(to_ndc(x0, y0 + leg));
+				}
+			}
+
+			std::uint32_t triangles = cells * cells;
+
+			result.push_back({
+				.name = "raster/triangle " + std::to_string(leg) + "px x" + std::to_string(triangles),
+				.items_per_op = triangles * leg * leg / 2.0,
+				.run = [positions, triangles](std::uint64_t count)
+				{
+					framebuffer framebuffer{.color = state.color.view(), .depth = state.depth.view()};
+					viewport viewport{0, 0, (std::int32_t)size, (std::int32_t)size};
+
+					draw_command command
+					{
+						.mesh = {
+							.positions = {positions->data(), sizeof(vector3f)},
+							.normals = {&mesh::default_normal, 0},
+							.colors = {&mesh::default_color, 0},
+							.texcoords = {&mesh::default_texcoord, 0},
+							.count = triangles * 3,
+						},
+						.depth = {.write = true, .mode = depth_test_mode::always},
+					};
+
+					for (std::uint64_t i = 0; i < count; ++i)
+						draw(framebuffer, viewport, command);
+				},
+			});
+
+			// The same grid through a user shader draw, compiled here rather than dispatched
+			result.push_back({
+				.name = "shader/triangle " + std::to_string(leg) + "px x" + std::to_string(triangles),
+				.items_per_op = triangles * leg * leg / 2.0,
+				.run = [positions, triangles](std::uint64_t count)
+				{
+					framebuffer framebuffer{.color = state.color.view(), .depth = state.depth.view()};
+					viewport viewport{0, 0, (std::int32_t)size, (std::int32_t)size};
+
+					struct no_varyings {};
+
+					shader_command command
+					{
+						.vertex_shader = [&](std::uint32_t index){ return shaded_vertex<no_varyings>{.position = as_point((*positions)[index]), .varyings = {}}; },
+						.fragment_shader = [](fragment<no_varyings> const &){ return mesh::default_color; },
+						.count = triangles * 3,
+						.depth = {.write = true, .mode = depth_test_mode::always},
+					};
+
+					for (std::uint64_t i = 0; i < count; ++i)
+						draw(framebuffer, viewport, command);
+				},
+			});
+		}
+
+		return result;
+	}
+
+	texture<color4ub> make_noise_texture(std::uint32_t size)
+	{
+		auto level = image<color4ub>::allocate(size, size);
+
+		std::uint32_t seed = 12345;
+		for (std::uint32_t y = 0; y < size; ++y)
+		{
+			for (std::uint32_t x = 0; x < size; ++x)
+			{
+				seed = seed * 1664525u + 1013904223u;
+				level.at(x, y) = {std::uint8_t(seed >> 24), std::uint8_t(seed >> 16), std::uint8_t(seed >> 8), 255};
+			}
+		}
+
+		texture<color4ub> result;
+		result.mipmaps.push_back(level);
+		return result;
+	}
+
+	// Texture sampling: 2x2 quads walking over the texture, footprint is the number
+	// of texels per pixel along each axis
+
+	template <typename Texture>
+	benchmark sample_benchmark(std::string name, Texture const & texture, filtering filter, float footprint)
+	{
+		return benchmark
+		{
+			.name = std::move(name),
+			.items_per_op = 4.0,
+			.run = [&texture, filter, footprint](std::uint64_t count)
+			{
+				texel_fetcher<Texture> fetch;
+				sampler sampler{.mag_filter = filter, .min_filter = filter};
+
+				float const step = footprint / texture.width();
+
+				for (std::uint64_t i = 0; i < count; ++i)
+				{
+					float x = 2.f * (i % 256);
+					float y = 2.f * ((i / 256) % 256);
+
+					vector2f texcoord[2][2] =
+					{
+						{{x * step, y * step}, {(x + 1.f) * step, y * step}},
+						{{x * step, (y + 1.f) * step}, {(x + 1.f) * step, (y + 1.f) * step}},
+					};
+
+					for (int dy = 0; dy < 2; ++dy)
+						for (int dx = 0; dx < 2; ++dx)
+							keep(sample(texture, sampler, fetch, texcoord, dx, dy));
+				}
+			},
+		};
+	}
+
+	std::vector<benchmark> sample_benchmarks()
+	{
+		static texture<color4ub> const rgba = []{
+			auto result = make_noise_texture(1024);
+			generate_mipmaps(result);
+			return result;
+		}();
+
+		static compressed_texture<bc1_block> const bc1 = compress_bc1(rgba);
+
+		std::vector<benchmark> result;
+
+		for (float footprint : {0.25f, 1.f, 4.f, 16.f})
+		{
+			char suffix[32];
+			std::snprintf(suffix, sizeof(suffix), " footprint %g", footprint);
+
+			result.push_back(sample_benchmark(std::string("sample/rgba8 nearest") + suffix, rgba, filtering::nearest, footprint));
+			result.push_back(sample_benchmark(std::string("sample/rgba8 linear") + suffix, rgba, filtering::linear, footprint));
+			result.push_back(sample_benchmark(std::string("sample/bc1 linear") + suffix, bc1, filtering::linear, footprint));
+		}
+
+		return result;
+	}
+
+	// Lighting: one directional light plus a number of point lights, per pixel
+
+	std::vector<benchmark> lighting_benchmarks()
+	{
+		std::vector<benchmark> result;
+
+		for (std::uint32_t point_light_count : {0u, 1u, 4u, 16u, 64u})
+		{
+			auto point_lights = std::make_shared<std::vector<point_light>>();
+			for (std::uint32_t i = 0; i < point_light_count; ++i)
+			{
+				float angle = i * 2.f * M_PIf / std::max(1u, point_light_count);
+				point_lights->push_back({{3.f * std::cos(angle), 1.f, 3.f * std::sin(angle)}, {0.5f, 0.5f, 0.5f}, {1.f, 0.f, 0.5f}});
+			}
+
+			result.push_back({
+				.name = "lighting/1 directional + " + std::to_string(point_light_count) + " point",
+				.items_per_op = 1.0,
+				.run = [point_lights](std::uint64_t count)
+				{
+					static directional_light const sun{normalized(vector3f{1.f, 1.f, 1.f}), {1.f, 1.f, 1.f}};
+
+					light_settings lights
+					{
+						.ambient_light = {0.2f, 0.2f, 0.2f},
+						.directional_lights = {&sun, 1},
+						.point_lights = *point_lights,
+					};
+
+					for (std::uint64_t i = 0; i < count; ++i)
+					{
+						float t = (i % 1024) / 1024.f;
+						vector3f position{t, 0.f, 1.f - t};
+						vector3f normal = normalized(vector3f{t - 0.5f, 1.f, 0.5f - t});
+						keep(compute_lighting(lights, position, normal));
+					}
+				},
+			});
+		}
+
+		return result;
+	}
+
+	// Clears of a 1920x1080 buffer
+
+	template <typename Pixel, typename Value>
+	benchmark clear_benchmark(std::string name, image_layout layout, Value value)
+	{
+		static constexpr std::uint32_t width = 1920;
+		static constexpr std::uint32_t height = 1080;
+
+		auto buffer = std::make_shared<image<Pixel>>(image<Pixel>::allocate(width, height, {.layout = layout}));
+
+		return benchmark
+		{
+			.name = std::move(name),
+			.items_per_op = double(width) * height,
+			.bytes_per_op = double(width) * height * sizeof(Pixel),
+			.run = [buffer, value](std::uint64_t count)
+			{
+				for (std::uint64_t i = 0; i < count; ++i)
+					clear(buffer->view(), value);
+			},
+		};
+	}
+
+	std::vector<benchmark> clear_benchmarks()
+	{
+		std::vector<benchmark> result;
+
+		for (auto layout : {image_layout::linear, image_layout::tiled})
+		{
+			std::string suffix = layout == image_layout::linear ? " linear" : " tiled";
+
+			result.push_back(clear_benchmark<color4ub>("clear/color" + suffix, layout, vector4f{0.9f, 0.9f, 0.9f, 1.f}));
+			result.push_back(clear_benchmark<std::uint32_t>("clear/depth D32" + suffix, layout, std::uint32_t(-1)));
+			result.push_back(clear_benchmark<depth24>("clear/depth D24" + suffix, layout, std::uint32_t(0xffffff)));
+			result.push_back(clear_benchmark<std::uint16_t>("clear/depth D16" + suffix, layout, std::uint16_t(0xffff)));
+		}
+
+		auto compressed = std::make_shared<compressed_depth_buffer>(compressed_depth_buffer::allocate(1920, 1080));
+		auto tiles = compressed->tiles;
+
+		result.push_back({
+			.name = "clear/depth compressed",
+			.items_per_op = 1920.0 * 1080.0,
+			.bytes_per_op = double(tiles.width) * tiles.height * sizeof(depth_tile),
+			.run = [compressed](std::uint64_t count)
+			{
+				for (std::uint64_t i = 0; i < count; ++i)
+					clear(compressed->view(), 1.f);
+			},
+		});
+
+		return result;
+	}
+
+	// Full mipmap chains, bytes are those read from every level but the last one
+
+	std::vector<benchmark> mipmap_benchmarks()
+	{
+		static thread_pool pool;
+
+		std::vector<benchmark> result;
+
+		for (std::uint32_t size : {256u, 1024u, 2048u})
+		{
+			auto source = std::make_shared<texture<color4ub>>(make_noise_texture(size));
+
+			for (bool parallel : {false, true})
+			{
+				if (parallel && pool.thread_count() <= 1)
+					continue;
+
+				result.push_back({
+					.name = "mipmaps/" + std::to_string(size) + (parallel ? " pool" : " single thread"),
+					.items_per_op = double(size) * size,
+					.bytes_per_op = double(size) * size * sizeof(color4ub) * 4.0 / 3.0,
+					.run = [source, parallel](std::uint64_t count)
+					{
+						for (std::uint64_t i = 0; i < count; ++i)
+						{
+							source->mipmaps.resize(1);
+							generate_mipmaps(*source, parallel ? &pool : nullptr);
+						}
+					},
+				});
+			}
+		}
+
+		return result;
+	}
+
+	int usage()
+	{
+		std::fprintf(stderr,
+			"usage: tiny-rasterizer-bench [options] [filter...]\n"
+			"  Runs the benchmarks whose name contains any of the filters, or all of them\n"
+			"  --repetitions N   timed repetitions per benchmark (11)\n"
+			"  --min-time MS     minimum duration of one repetition (20)\n"
+			"  --perf            also report hardware counters per operation (Linux)\n");
+		return 1;
+	}
+
+}
+
+int main(int argc, char ** argv)
+{
+	settings settings;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string_view argument = argv[i];
+
+		if (argument == "--repetitions" && i + 1 < argc)
+			settings.repetitions = std::max(1, std::atoi(argv[++i]));
+		else if (argument == "--min-time" && i + 1 < argc)
+			settings.min_time = std::atof(argv[++i]) / 1000.0;
+		else if (argument == "--perf")
+			settings.perf = true;
+		else if (argument.starts_with("--"))
+			return usage();
+		else
+			settings.filters.emplace_back(argument);
+	}
+
+	if (settings.perf && !enable_perf_counters())
+	{
+		std::fprintf(stderr, "Hardware counters are not available\n");
+		settings.perf = false;
+	}
+
+	std::function<std::vector<benchmark>()> const groups[] =
+	{
+		clip_benchmarks,
+		attribute_benchmarks,
+		raster_benchmarks,
+		sample_benchmarks,
+		lighting_benchmarks,
+		clear_benchmarks,
+		mipmap_benchmarks,
+	};
+
+	for (auto const & group : groups)
+		for (auto const & benchmark : group())
+			if (selected(settings, benchmark.name))
+				measure(settings, benchmark);
+}
@@ -0,0 +1,261 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <rasterizer/renderer.hpp>
+#include <rasterizer/image.hpp>
+#include <rasterizer/heatmap.hpp>
+#include <rasterizer/texture_file.hpp>
+#include <rasterizer/thread_pool.hpp>
+#include <rasterizer/trace.hpp>
+#include <rasterizer/capture.hpp>
+
+#include "scene.hpp"
+
+using namespace rasterizer;
+
+// Renders a demo scene to in-memory images, without a window, and reports throughput
+
+int usage()
+{
+	std::cerr <<
+		"usage: tiny-rasterizer-headless [options]\n"
+		"  --scene NAME             scene to render: cube, cube-grid, overdraw, tiny-triangles,\n"
+		"                           many-lights or near-clip (cube)\n"
+		"  --grid N                 cubes per side of the cube grid (10)\n"
+		"  --camera fixed|orbit|dolly\n"
+		"                           camera path (orbit)\n"
+		"  --width W --height H     resolution (800x600)\n"
+		"  --frames N               number of frames (100)\n"
+		"  --fps F                  frame rate the camera path is sampled at (60)\n"
+		"  --no-texture             draw untextured\n"
+		"  --output DIRECTORY       write every frame to DIRECTORY/frame_NNNN.<format>\n"
+		"  --format tga|ppm         format of written frames (tga)\n"
+		"  --heatmaps               along with every written frame, write false-color heatmaps\n"
+		"                           of depth tests, shading, writes and per-tile cost\n"
+		"  --trace FILE             write a Chrome trace of the last frames to FILE,\n"
+		"                           with zones when built with RASTERIZER_TRACE\n"
+		"  --capture FILE           record every clear & draw into FILE, for tiny-rasterizer-replay\n";
+	return 1;
+}
+
+int main(int argc, char ** argv)
+{
+	demo::scene_settings scene;
+	demo::camera_path camera_path = demo::camera_path::orbit;
+
+	std::uint32_t width = 800;
+	std::uint32_t height = 600;
+	std::uint32_t frame_count = 100;
+	float fps = 60.f;
+	bool textured = true;
+	bool heatmaps = false;
+	std::filesystem::path output_directory;
+	std::string format = "tga";
+	std::filesystem::path trace_path;
+	std::filesystem::path capture_path;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string_view option = argv[i];
+
+		if (option == "--no-texture")
+		{
+			textured = false;
+			continue;
+		}
+
+		if (option == "--heatmaps")
+		{
+			heatmaps = true;
+			continue;
+		}
+
+		if (i + 1 == argc)
+			return usage();
+
+		std::string_view value = argv[++i];
+
+		if (option == "--scene")
+		{
+			auto kind = demo::parse_scene_kind(value);
+			if (!kind)
+				return usage();
+			scene.kind = *kind;
+		}
+		else if (option == "--camera")
+		{
+			auto path = demo::parse_camera_path(value);
+			if (!path)
+				return usage();
+			camera_path = *path;
+		}
+		else if (option == "--grid")
+			scene.grid_size = std::atoi(value.data());
+		else if (option == "--width")
+			width = std::atoi(value.data());
+		else if (option == "--height")
+			height = std::atoi(value.data());
+		else if (option == "--frames")
+			frame_count = std::atoi(value.data());
+		else if (option == "--fps")
+			fps = std::atof(value.data());
+		else if (option == "--output")
+			output_directory = value;
+		else if (option == "--format" && (value == "tga" || value == "ppm"))
+			format = value;
+		else if (option == "--trace")
+			trace_path = value;
+		else if (option == "--capture")
+			capture_path = value;
+		else
+			return usage();
+	}
+
+	if (width == 0 || height == 0 || fps <= 0.f || (heatmaps && output_directory.empty()))
+		return usage();
+
+	trace::set_thread_name("main");
+
+	thread_pool pool;
+
+	texture<color4ub> albedo;
+
+	if (textured)
+	{
+		std::filesystem::path project_root = PROJECT_ROOT;
+		albedo = load_texture_cached(project_root / "assets" / "brick_1024.jpg", std::filesystem::temp_directory_path() / "tiny-rasterizer-cache", &pool);
+
+		if (albedo.mipmaps.empty())
+		{
+			std::cerr << "Failed to load the brick texture\n";
+			return 1;
+		}
+
+		scene.albedo = texture_and_sampler
+		{
+			.texture = &albedo,
+			.sampler = {
+				.mag_filter = filtering::linear,
+				.min_filter = filtering::linear,
+			},
+		};
+	}
+
+	if (!output_directory.empty())
+	{
+		std::error_code error;
+		std::filesystem::create_directories(output_directory, error);
+	}
+
+	auto color_buffer = image<color4ub>::allocate(width, height, {.layout = image_layout::tiled});
+	auto depth_buffer = image<std::uint32_t>::allocate(width, height, {.layout = image_layout::tiled});
+
+	heatmap_buffers heatmap_buffers;
+	image<color4ub> heatmap_image;
+
+	if (heatmaps)
+	{
+		heatmap_buffers = heatmap_buffers::allocate(width, height);
+		heatmap_image = image<color4ub>::allocate(width, height);
+	}
+
+	framebuffer framebuffer
+	{
+		.color = color_buffer.view(),
+		.depth = depth_buffer.view(),
+		.heatmaps = heatmap_buffers.view(),
+	};
+
+	demo::frame_commands commands;
+
+	if (!capture_path.empty() && !capture::start(capture_path))
+	{
+		std::cerr << "Failed to write " << capture_path << "\n";
+		return 1;
+	}
+
+	using clock = std::chrono::steady_clock;
+
+	clock::duration render_time{};
+
+	for (std::uint32_t i = 0; i < frame_count; ++i)
+	{
+		RASTERIZER_TRACE_ZONE("frame");
+
+		auto start = clock::now();
+
+		{
+			RASTERIZER_TRACE_ZONE("record");
+			demo::record(scene, demo::camera_at(camera_path, i / fps), width, height, commands);
+		}
+
+		clear(framebuffer.color, {0.9f, 0.9f, 0.9f, 1.f});
+		clear(framebuffer.depth, 1.f);
+		clear(framebuffer.heatmaps);
+
+		for (auto const & command : commands.commands)
+			draw(framebuffer, commands.viewport, command);
+
+		render_time += clock::now() - start;
+
+		capture::end_frame();
+
+		if (!output_directory.empty())
+		{
+			RASTERIZER_TRACE_ZONE("save");
+
+			char name[64];
+			std::snprintf(name, sizeof(name), "frame_%04u.%s", i, format.c_str());
+
+			if (!save_image(output_directory / name, framebuffer.color))
+			{
+				std::cerr << "Failed to write " << (output_directory / name) << "\n";
+				return 1;
+			}
+
+			std::pair<char const *, image_view<std::uint32_t>> const maps[]
+			{
+				{"depth_tests", framebuffer.heatmaps.depth_tests},
+				{"shaded", framebuffer.heatmaps.shaded},
+				{"writes", framebuffer.heatmaps.writes},
+				{"tile_cost", framebuffer.heatmaps.tile_cost},
+			};
+
+			for (auto const & [map_name, values] : maps)
+			{
+				if (!values)
+					continue;
+
+				false_color(values, heatmap_image.view());
+
+				std::snprintf(name, sizeof(name), "frame_%04u_%s.%s", i, map_name, format.c_str());
+
+				if (!save_image(output_directory / name, heatmap_image.view()))
+				{
+					std::cerr << "Failed to write " << (output_directory / name) << "\n";
+					return 1;
+				}
+			}
+		}
+	}
+
+	capture::stop();
+
+	if (!trace_path.empty() && !trace::write_chrome_trace(trace_path))
+	{
+		std::cerr << "Failed to write " << trace_path << "\n";
+		return 1;
+	}
+
+	double seconds = std::chrono::duration<double>(render_time).count();
+
+	std::cout << frame_count << " frames at " << width << "x" << height << " in " << seconds << " s: "
+		<< (seconds * 1000.0 / frame_count) << " ms/frame, "
+		<< (frame_count / seconds) << " frames/s, "
+		<< (double(width) * height * frame_count / seconds / 1e6) << " Mpixels/s\n";
+}
@@ -0,0 +1,260 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include <rasterizer/capture.hpp>
+#include <rasterizer/image.hpp>
+#include <rasterizer/perf_counters.hpp>
+#include <rasterizer/trace.hpp>
+
+using namespace rasterizer;
+
+// Re-executes a capture written with capture::start (e.g. with the --capture option of the
+// headless renderer) and reports how long its frames take, so that a slow scene can be
+// reproduced, profiled & bisected without the application that rendered it
+
+namespace
+{
+
+	struct summary
+	{
+		double mean = 0.0;
+		double p50 = 0.0;
+		double p95 = 0.0;
+		double max = 0.0;
+	};
+
+	// Nearest-rank percentiles
+	summary summarize(std::vector<double> values)
+	{
+		summary result;
+
+		if (values.empty())
+			return result;
+
+		std::sort(values.begin(), values.end());
+
+		for (double value : values)
+			result.mean += value;
+		result.mean /= values.size();
+
+		auto percentile = [&](double p)
+		{
+			std::size_t rank = (std::size_t)std::ceil(p * values.size());
+			return values[std::clamp<std::size_t>(rank, 1, values.size()) - 1];
+		};
+
+		result.p50 = percentile(0.50);
+		result.p95 = percentile(0.95);
+		result.max = values.back();
+
+		return result;
+	}
+
+	int usage()
+	{
+		std::fprintf(stderr,
+			"usage: tiny-rasterizer-replay [options] CAPTURE\n"
+			"  --passes N               times the capture is replayed and timed (10)\n"
+			"  --warmup N               untimed passes first (1)\n"
+			"  --frame I                only replay frame I\n"
+			"  --per-frame              print the times of every frame\n"
+			"  --stats                  print the pipeline statistics of one extra pass\n"
+			"  --perf                   count hardware events in the draws of that pass (Linux)\n"
+			"  --output DIRECTORY       write the color buffers after the last pass as PPM\n"
+			"  --trace FILE             write a Chrome trace of the last passes to FILE,\n"
+			"                           needs a build with RASTERIZER_TRACE\n");
+		return 2;
+	}
+
+}
+
+int main(int argc, char ** argv)
+{
+	std::filesystem::path capture_path;
+	std::uint32_t passes = 10;
+	std::uint32_t warmup = 1;
+	std::optional<std::size_t> only_frame;
+	bool per_frame = false;
+	bool print_stats = false;
+	bool perf = false;
+	std::filesystem::path output_directory;
+	std::filesystem::path trace_path;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string_view option = argv[i];
+
+		if (option == "--per-frame")
+			per_frame = true;
+		else if (option == "--stats")
+			print_stats = true;
+		else if (option == "--perf")
+			perf = print_stats = true;
+		else if (option.starts_with("--") && i + 1 < argc)
+		{
+			char const * value = argv[++i];
+
+			if (option == "--passes")
+				passes = std::max(1, std::atoi(value));
+			else if (option == "--warmup")
+				warmup = std::max(0, std::atoi(value));
+			else if (option == "--frame")
+				only_frame = std::strtoull(value, nullptr, 10);
+			else if (option == "--output")
+				output_directory = value;
+			else if (option == "--trace")
+				trace_path = value;
+			else
+				return usage();
+		}
+		else if (!option.starts_with("--") && capture_path.empty())
+			capture_path = option;
+		else
+			return usage();
+	}
+
+	if (capture_path.empty())
+		return usage();
+
+	auto replay = capture::replay::load(capture_path);
+
+	if (!replay)
+	{
+		std::fprintf(stderr, "Failed to load the capture %s\n", capture_path.string().c_str());
+		return 1;
+	}
+
+	std::size_t frame_begin = 0;
+	std::size_t frame_end = replay.frame_count();
+
+	if (only_frame)
+	{
+		if (*only_frame >= frame_end)
+		{
+			std::fprintf(stderr, "The capture only has %zu frames\n", frame_end);
+			return 1;
+		}
+
+		frame_begin = *only_frame;
+		frame_end = frame_begin + 1;
+	}
+
+	if (perf && !enable_perf_counters())
+		std::fprintf(stderr, "Hardware counters are not available\n");
+
+	trace::set_thread_name("main");
+
+	std::size_t draw_count = 0;
+	for (auto frame = frame_begin; frame < frame_end; ++frame)
+		draw_count += replay.draw_count(frame);
+
+	std::printf("%s: %zu frames, %zu draws, %zu color buffers\n", capture_path.string().c_str(), frame_end - frame_begin, draw_count, replay.color_buffer_count());
+
+	using clock = std::chrono::steady_clock;
+
+	for (std::uint32_t pass = 0; pass < warmup; ++pass)
+		for (auto frame = frame_begin; frame < frame_end; ++frame)
+			replay.play(frame);
+
+	// Indexed by frame, then pass
+	std::vector<std::vector<double>> frame_times(frame_end - frame_begin);
+	std::vector<double> all_times;
+	std::vector<double> pass_times;
+
+	for (std::uint32_t pass = 0; pass < passes; ++pass)
+	{
+		RASTERIZER_TRACE_ZONE("pass");
+
+		double pass_time = 0.0;
+
+		for (auto frame = frame_begin; frame < frame_end; ++frame)
+		{
+			RASTERIZER_TRACE_ZONE("frame");
+
+			auto start = clock::now();
+			replay.play(frame);
+			double milliseconds = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+			frame_times[frame - frame_begin].push_back(milliseconds);
+			all_times.push_back(milliseconds);
+			pass_time += milliseconds;
+		}
+
+		pass_times.push_back(pass_time);
+	}
+
+	auto print_summary = [](char const * name, summary const & summary)
+	{
+		std::printf("  %-10s mean %9.3f  p50 %9.3f  p95 %9.3f  max %9.3f ms\n", name, summary.mean, summary.p50, summary.p95, summary.max);
+	};
+
+	print_summary("frame", summarize(all_times));
+	print_summary("pass", summarize(pass_times));
+
+	if (per_frame)
+	{
+		for (auto frame = frame_begin; frame < frame_end; ++frame)
+		{
+			auto summary = summarize(frame_times[frame - frame_begin]);
+			std::printf("  frame %-4zu %5zu draws  mean %9.3f  p50 %9.3f  max %9.3f ms\n", frame, replay.draw_count(frame), summary.mean, summary.p50, summary.max);
+		}
+	}
+
+	// Counting stats slows draws down a little, so they're counted in a pass of their own
+	if (print_stats)
+	{
+		render_stats stats;
+
+		for (auto frame = frame_begin; frame < frame_end; ++frame)
+			replay.play(frame, &stats);
+
+		std::printf("  %llu triangles: %llu clipped, %llu rejected by clipping, %llu culled, %llu zero-area, %llu rasterized\n",
+			(unsigned long long)stats.triangles, (unsigned long long)stats.clipped_triangles,
+			(unsigned long long)stats.clip_rejected_triangles, (unsigned long long)stats.culled_triangles,
+			(unsigned long long)stats.zero_area_triangles, (unsigned long long)stats.rasterized_triangles);
+		std::printf("  %llu quads, %llu pixels covered, %llu passed depth, %llu shaded, %.1f%% quad efficiency\n",
+			(unsigned long long)stats.quads, (unsigned long long)stats.covered_pixels,
+			(unsigned long long)stats.depth_passed_pixels, (unsigned long long)stats.shaded_pixels,
+			100.0 * stats.quad_efficiency());
+
+		if (stats.perf.available != 0)
+		{
+			std::printf("  draws:");
+			for (std::size_t i = 0; i < perf_counter_count; ++i)
+				if (stats.perf.has(perf_counter(i)))
+					std::printf(" %llu %s", (unsigned long long)stats.perf.values[i], perf_counter_names[i]);
+			std::printf("\n");
+		}
+	}
+
+	if (!output_directory.empty())
+	{
+		std::error_code error;
+		std::filesystem::create_directories(output_directory, error);
+
+		for (std::size_t i = 0; i < replay.color_buffer_count(); ++i)
+		{
+			char name[64];
+			std::snprintf(name, sizeof(name), "buffer_%02zu.ppm", i);
+
+			if (!save_image(output_directory / name, replay.color_buffer(i)))
+			{
+				std::fprintf(stderr, "Failed to write %s\n", (output_directory / name).string().c_str());
+				return 1;
+			}
+		}
+	}
+
+	if (!trace_path.empty() && !trace::write_chrome_trace(trace_path))
+	{
+		std::fprintf(stderr, "Failed to write %s\n", trace_path.string().c_str());
+		return 1;
+	}
+}
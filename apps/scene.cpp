@@ -0,0 +1,248 @@
+#include "scene.hpp"
+
+#include <rasterizer/cube.hpp>
+#include <rasterizer/primitives.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace demo
+{
+
+	namespace
+	{
+
+		vector4f const white{1.f, 1.f, 1.f, 1.f};
+
+		// Both vertex formats of a generated mesh
+		struct generated_mesh
+		{
+			mesh_data data;
+			packed_mesh_data packed = pack(data);
+			mesh view = data.view();
+			mesh packed_view = packed.view();
+
+			mesh const & get(bool packed_vertices) const
+			{
+				return packed_vertices ? packed_view : view;
+			}
+		};
+
+		// Generated once, on first use
+		mesh const & tiny_triangle_sphere(bool packed)
+		{
+			static generated_mesh const sphere{make_sphere(256, 512)};
+			return sphere.get(packed);
+		}
+
+		mesh const & single_quad_plane(bool packed)
+		{
+			static generated_mesh const plane{make_plane(1)};
+			return plane.get(packed);
+		}
+
+		mesh const & ground_plane(bool packed)
+		{
+			static generated_mesh const plane{make_plane(16)};
+			return plane.get(packed);
+		}
+
+		draw_command mesh_command(scene_settings const & scene, frame_commands const & frame, mesh const & mesh, matrix4x4f const & model, matrix4x4f const & view, matrix4x4f const & projection)
+		{
+			return draw_command
+			{
+				.mesh = {
+					.positions = mesh.positions,
+					.normals = mesh.normals,
+					.colors = {&white, 0},
+					.texcoords = mesh.texcoords,
+					.indices = mesh.indices,
+					.count = mesh.count,
+				},
+				.cull_mode = cull_mode::cw,
+				.depth = {
+					.write = true,
+					.mode = depth_test_mode::less,
+				},
+				.model = model,
+				.view = view,
+				.projection = projection,
+				.lights = light_settings {
+					.ambient_light = {0.2f, 0.2f, 0.2f},
+					.directional_lights = frame.directional_lights,
+					.point_lights = frame.point_lights,
+				},
+				.albedo = scene.albedo,
+			};
+		}
+
+		void record_cube_grid(scene_settings const & scene, camera const & camera, float aspect_ratio, frame_commands & result)
+		{
+			// Cubes are 2 units wide, spaced 3 units apart, and the camera
+			// pulls back so that the whole grid stays in view, far plane included
+			float extent = 3.f * scene.grid_size;
+			matrix4x4f projection = matrix4x4f::perspective(0.1f, std::max(100.f, camera.distance + 2.f * extent), M_PIf / 3.f, aspect_ratio);
+			matrix4x4f view = matrix4x4f::translate({0.f, 0.f, -camera.distance - extent}) * matrix4x4f::rotateYZ(M_PIf / 6.f) * matrix4x4f::rotateZX(camera.angle);
+
+			for (std::uint32_t z = 0; z < scene.grid_size; ++z)
+			{
+				for (std::uint32_t x = 0; x < scene.grid_size; ++x)
+				{
+					vector3f position{3.f * x - 1.5f * (scene.grid_size - 1), 0.f, 3.f * z - 1.5f * (scene.grid_size - 1)};
+					matrix4x4f model = matrix4x4f::translate(position) * matrix4x4f::rotateZX(0.3f * (x + z));
+
+					result.commands.push_back(mesh_command(scene, result, cube, model, view, projection));
+				}
+			}
+		}
+
+	}
+
+	camera camera_at(camera_path path, float time)
+	{
+		switch (path)
+		{
+		case camera_path::fixed:
+			break;
+		case camera_path::orbit:
+			return {.angle = time * M_PIf / 2.f};
+		case camera_path::dolly:
+			return {.angle = 0.5f, .distance = 5.5f - 2.5f * std::cos(time)};
+		}
+
+		return {};
+	}
+
+	std::optional<scene_kind> parse_scene_kind(std::string_view name)
+	{
+		if (name == "cube")
+			return scene_kind::cube;
+		if (name == "cube-grid")
+			return scene_kind::cube_grid;
+		if (name == "overdraw")
+			return scene_kind::overdraw;
+		if (name == "tiny-triangles")
+			return scene_kind::tiny_triangles;
+		if (name == "many-lights")
+			return scene_kind::many_lights;
+		if (name == "near-clip")
+			return scene_kind::near_clip;
+		return std::nullopt;
+	}
+
+	std::optional<camera_path> parse_camera_path(std::string_view name)
+	{
+		if (name == "fixed")
+			return camera_path::fixed;
+		if (name == "orbit")
+			return camera_path::orbit;
+		if (name == "dolly")
+			return camera_path::dolly;
+		return std::nullopt;
+	}
+
+	void record(scene_settings const & scene, camera const & camera, std::uint32_t width, std::uint32_t height, frame_commands & result)
+	{
+		result.viewport =
+		{
+			.xmin = 0,
+			.ymin = 0,
+			.xmax = (std::int32_t)width,
+			.ymax = (std::int32_t)height,
+		};
+
+		result.directional_lights =
+		{
+			{
+				normalized(vector3f{1.f, 1.f, 1.f}),
+				{1.f, 1.f, 1.f},
+			},
+		};
+
+		result.point_lights.clear();
+		result.commands.clear();
+
+		matrix4x4f projection = matrix4x4f::perspective(0.1f, 100.f, M_PIf / 3.f, width * 1.f / height);
+
+		switch (scene.kind)
+		{
+		case scene_kind::cube:
+			{
+				matrix4x4f model = matrix4x4f::rotateZX(camera.angle);
+				matrix4x4f view = matrix4x4f::translate({0.f, 0.f, -camera.distance}) * matrix4x4f::rotateYZ(M_PIf / 12.f);
+
+				result.commands.push_back(mesh_command(scene, result, cube, model, view, projection));
+			}
+			break;
+		case scene_kind::cube_grid:
+			record_cube_grid(scene, camera, width * 1.f / height, result);
+			break;
+		case scene_kind::overdraw:
+			{
+				matrix4x4f view = matrix4x4f::rotateXY(camera.angle * 0.1f);
+
+				// Each layer is scaled with its distance so that it covers the screen,
+				// and the nearest layer stays just behind the camera distance
+				for (std::uint32_t i = scene.layer_count; i-- > 0;)
+				{
+					float distance = camera.distance + 0.1f * i;
+					matrix4x4f model = matrix4x4f::translate({0.f, 0.f, -distance}) * matrix4x4f::scale(distance);
+
+					result.commands.push_back(mesh_command(scene, result, single_quad_plane(scene.packed_vertices), model, view, projection));
+				}
+			}
+			break;
+		case scene_kind::tiny_triangles:
+			{
+				matrix4x4f model = matrix4x4f::rotateZX(camera.angle);
+				matrix4x4f view = matrix4x4f::translate({0.f, 0.f, -camera.distance}) * matrix4x4f::rotateYZ(M_PIf / 12.f);
+
+				result.commands.push_back(mesh_command(scene, result, tiny_triangle_sphere(scene.packed_vertices), model, view, projection));
+			}
+			break;
+		case scene_kind::many_lights:
+			{
+				// Colored lights on a ring just above the cubes
+				float radius = 1.5f * scene.grid_size;
+
+				for (std::uint32_t i = 0; i < scene.light_count; ++i)
+				{
+					float angle = 2.f * M_PIf * i / scene.light_count;
+
+					result.point_lights.push_back(
+					{
+						.position = {radius * std::cos(angle), 2.f, radius * std::sin(angle)},
+						.intensity = {
+							0.5f + 0.5f * std::cos(angle),
+							0.5f + 0.5f * std::cos(angle + 2.f * M_PIf / 3.f),
+							0.5f + 0.5f * std::cos(angle - 2.f * M_PIf / 3.f),
+						},
+						.attenuation = {1.f, 0.f, 0.1f},
+					});
+				}
+
+				record_cube_grid(scene, camera, width * 1.f / height, result);
+			}
+			break;
+		case scene_kind::near_clip:
+			{
+				// The camera turns in place, 1 unit above the ground
+				matrix4x4f view = matrix4x4f::rotateZX(camera.angle) * matrix4x4f::translate({0.f, -1.f, 0.f});
+
+				matrix4x4f ground = matrix4x4f::scale(100.f) * matrix4x4f::rotateYZ(-M_PIf / 2.f);
+				result.commands.push_back(mesh_command(scene, result, ground_plane(scene.packed_vertices), ground, view, projection));
+
+				// The nearest face of each cube is closer than the near plane
+				for (std::uint32_t i = 0; i < 16; ++i)
+				{
+					float angle = 2.f * M_PIf * i / 16.f;
+					matrix4x4f model = matrix4x4f::translate({1.5f * std::cos(angle), 1.f, 1.5f * std::sin(angle)}) * matrix4x4f::rotateZX(angle) * matrix4x4f::scale(1.45f);
+
+					result.commands.push_back(mesh_command(scene, result, cube, model, view, projection));
+				}
+			}
+			break;
+		}
+	}
+
+}
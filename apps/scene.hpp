@@ -0,0 +1,89 @@
+#pragma once
+
+#include <rasterizer/draw_command.hpp>
+#include <rasterizer/viewport.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// Demo scenes shared by the windowed and headless executables
+
+namespace demo
+{
+
+	using namespace rasterizer;
+
+	enum class scene_kind
+	{
+		// The spinning textured cube
+		cube,
+
+		// grid_size x grid_size textured cubes on a plane
+		cube_grid,
+
+		// layer_count screen-filling planes drawn back to front, so that every
+		// layer passes the depth test
+		overdraw,
+
+		// A finely tessellated sphere with triangles around a pixel in size
+		tiny_triangles,
+
+		// The cube grid lit by light_count point lights
+		many_lights,
+
+		// The camera stands on a large plane, surrounded by cubes that cross
+		// the near plane
+		near_clip,
+	};
+
+	struct scene_settings
+	{
+		scene_kind kind = scene_kind::cube;
+		std::uint32_t grid_size = 10;
+		std::uint32_t layer_count = 16;
+		std::uint32_t light_count = 64;
+
+		// Draws generated meshes from compressed vertex attributes, see packed_mesh_data
+		bool packed_vertices = false;
+
+		std::optional<texture_and_sampler> albedo = {};
+	};
+
+	struct camera
+	{
+		// Rotation of the scene around the vertical axis, in radians
+		float angle = 0.f;
+		float distance = 5.f;
+	};
+
+	enum class camera_path
+	{
+		fixed,
+
+		// Full turn around the scene every 4 seconds
+		orbit,
+
+		// Moves back and forth between 3 and 8 units away
+		dolly,
+	};
+
+	camera camera_at(camera_path path, float time);
+
+	// Returns nothing for unknown names
+	std::optional<scene_kind> parse_scene_kind(std::string_view name);
+	std::optional<camera_path> parse_camera_path(std::string_view name);
+
+	// Draw commands of one frame, along with the data they point to
+	struct frame_commands
+	{
+		struct viewport viewport;
+		std::vector<directional_light> directional_lights;
+		std::vector<point_light> point_lights;
+		std::vector<draw_command> commands;
+	};
+
+	void record(scene_settings const & scene, camera const & camera, std::uint32_t width, std::uint32_t height, frame_commands & result);
+
+}
@@ -0,0 +1,420 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <rasterizer/renderer.hpp>
+#include <rasterizer/image.hpp>
+#include <rasterizer/texture_file.hpp>
+#include <rasterizer/thread_pool.hpp>
+#include <rasterizer/perf_counters.hpp>
+#include <rasterizer/cpu_features.hpp>
+
+#include "scene.hpp"
+
+using namespace rasterizer;
+
+// Renders stress scenes headless and reports the distribution of frame times, in total
+// and per stage; results can also be written as CSV or JSON to track them across changes
+
+namespace
+{
+
+	struct preset
+	{
+		std::string name;
+		demo::scene_settings scene;
+	};
+
+	std::vector<preset> const & presets()
+	{
+		static std::vector<preset> const result =
+		{
+			{"cubes-10k",             {.kind = demo::scene_kind::cube_grid, .grid_size = 100}},
+			{"overdraw",              {.kind = demo::scene_kind::overdraw}},
+			{"tiny-triangles",        {.kind = demo::scene_kind::tiny_triangles}},
+			{"tiny-triangles-packed", {.kind = demo::scene_kind::tiny_triangles, .packed_vertices = true}},
+			{"many-lights",           {.kind = demo::scene_kind::many_lights}},
+			{"near-clip",             {.kind = demo::scene_kind::near_clip}},
+		};
+
+		return result;
+	}
+
+	// Presets first, then any demo scene with its default settings
+	std::optional<preset> find_preset(std::string_view name)
+	{
+		for (auto const & preset : presets())
+			if (preset.name == name)
+				return preset;
+
+		if (auto kind = demo::parse_scene_kind(name))
+			return preset{std::string(name), {.kind = *kind}};
+
+		return std::nullopt;
+	}
+
+	enum stage
+	{
+		record,
+		clear,
+		draw,
+		resolve,
+		total,
+		stage_count,
+	};
+
+	char const * const stage_names[stage_count] = {"record", "clear", "draw", "resolve", "total"};
+
+	struct summary
+	{
+		double mean = 0.0;
+		double p50 = 0.0;
+		double p95 = 0.0;
+		double p99 = 0.0;
+		double max = 0.0;
+	};
+
+	// Nearest-rank percentiles
+	summary summarize(std::vector<double> values)
+	{
+		summary result;
+
+		if (values.empty())
+			return result;
+
+		std::sort(values.begin(), values.end());
+
+		for (double value : values)
+			result.mean += value;
+		result.mean /= values.size();
+
+		auto percentile = [&](double p)
+		{
+			std::size_t rank = (std::size_t)std::ceil(p * values.size());
+			return values[std::clamp<std::size_t>(rank, 1, values.size()) - 1];
+		};
+
+		result.p50 = percentile(0.50);
+		result.p95 = percentile(0.95);
+		result.p99 = percentile(0.99);
+		result.max = values.back();
+
+		return result;
+	}
+
+	struct scene_result
+	{
+		std::string name;
+		std::size_t draw_calls = 0;
+		std::uint64_t triangles = 0;
+		summary stages[stage_count] = {};
+
+		// Of one extra frame, rendered after the measured ones
+		render_stats stats = {};
+	};
+
+	struct settings
+	{
+		std::uint32_t width = 800;
+		std::uint32_t height = 600;
+		std::uint32_t frame_count = 100;
+		std::uint32_t warmup_frames = 5;
+		float fps = 60.f;
+	};
+
+	scene_result run(settings const & settings, preset const & preset)
+	{
+		using clock = std::chrono::steady_clock;
+
+		auto color_buffer = image<color4ub>::allocate(settings.width, settings.height, {.layout = image_layout::tiled});
+		auto depth_buffer = image<std::uint32_t>::allocate(settings.width, settings.height, {.layout = image_layout::tiled});
+		auto presented = image<color4ub>::allocate(settings.width, settings.height);
+
+		framebuffer framebuffer
+		{
+			.color = color_buffer.view(),
+			.depth = depth_buffer.view(),
+		};
+
+		demo::frame_commands commands;
+
+		std::vector<double> times[stage_count];
+
+		for (std::uint32_t i = 0; i < settings.warmup_frames + settings.frame_count; ++i)
+		{
+			clock::time_point marks[stage_count];
+
+			auto start = clock::now();
+
+			demo::record(preset.scene, demo::camera_at(demo::camera_path::orbit, i / settings.fps), settings.width, settings.height, commands);
+			marks[record] = clock::now();
+
+			rasterizer::clear(framebuffer.color, {0.9f, 0.9f, 0.9f, 1.f});
+			rasterizer::clear(framebuffer.depth, 1.f);
+			marks[clear] = clock::now();
+
+			for (auto const & command : commands.commands)
+				rasterizer::draw(framebuffer, commands.viewport, command);
+			marks[draw] = clock::now();
+
+			// Stands in for presenting: the tiled color buffer is copied to a linear image
+			copy(framebuffer.color, presented.view());
+			marks[resolve] = clock::now();
+
+			if (i < settings.warmup_frames)
+				continue;
+
+			auto previous = start;
+			for (int s = record; s <= resolve; ++s)
+			{
+				times[s].push_back(std::chrono::duration<double, std::milli>(marks[s] - previous).count());
+				previous = marks[s];
+			}
+
+			times[total].push_back(std::chrono::duration<double, std::milli>(previous - start).count());
+		}
+
+		scene_result result
+		{
+			.name = preset.name,
+			.draw_calls = commands.commands.size(),
+		};
+
+		for (auto const & command : commands.commands)
+			result.triangles += command.mesh.count / 3;
+
+		// Counting stats slows draws down a little, so they're not counted in measured frames
+		rasterizer::clear(framebuffer.color, {0.9f, 0.9f, 0.9f, 1.f});
+		rasterizer::clear(framebuffer.depth, 1.f);
+
+		for (auto const & command : commands.commands)
+			rasterizer::draw(framebuffer, commands.viewport, command, &result.stats);
+
+		for (int s = 0; s < stage_count; ++s)
+			result.stages[s] = summarize(std::move(times[s]));
+
+		return result;
+	}
+
+	void print(scene_result const & result)
+	{
+		auto const & stats = result.stats;
+
+		std::printf("%s: %zu draws, %llu triangles\n", result.name.c_str(), result.draw_calls, (unsigned long long)result.triangles);
+		std::printf("  %llu clipped, %llu rejected by clipping, %llu culled, %llu zero-area, %llu rasterized\n",
+			(unsigned long long)stats.clipped_triangles, (unsigned long long)stats.clip_rejected_triangles,
+			(unsigned long long)stats.culled_triangles, (unsigned long long)stats.zero_area_triangles,
+			(unsigned long long)stats.rasterized_triangles);
+		std::printf("  %llu quads, %llu pixels covered, %llu passed depth, %llu shaded, %.1f%% quad efficiency\n",
+			(unsigned long long)stats.quads, (unsigned long long)stats.covered_pixels,
+			(unsigned long long)stats.depth_passed_pixels, (unsigned long long)stats.shaded_pixels,
+			100.0 * stats.quad_efficiency());
+
+		if (stats.perf.available != 0)
+		{
+			std::printf("  draws:");
+			for (std::size_t i = 0; i < perf_counter_count; ++i)
+				if (stats.perf.has(perf_counter(i)))
+					std::printf(" %llu %s", (unsigned long long)stats.perf.values[i], perf_counter_names[i]);
+			std::printf("\n");
+		}
+
+		for (int s = 0; s < stage_count; ++s)
+		{
+			auto const & stage = result.stages[s];
+			std::printf("  %-8s mean %9.3f  p50 %9.3f  p95 %9.3f  p99 %9.3f  max %9.3f ms\n", stage_names[s], stage.mean, stage.p50, stage.p95, stage.p99, stage.max);
+		}
+
+		std::fflush(stdout);
+	}
+
+	bool write_csv(char const * path, settings const & settings, std::vector<scene_result> const & results)
+	{
+		std::ofstream file(path);
+		if (!file)
+			return false;
+
+		file << "scene,width,height,frames,draws,triangles,stage,mean_ms,p50_ms,p95_ms,p99_ms,max_ms\n";
+
+		for (auto const & result : results)
+		{
+			for (int s = 0; s < stage_count; ++s)
+			{
+				auto const & stage = result.stages[s];
+				file << result.name << ',' << settings.width << ',' << settings.height << ',' << settings.frame_count << ','
+					<< result.draw_calls << ',' << result.triangles << ',' << stage_names[s] << ','
+					<< stage.mean << ',' << stage.p50 << ',' << stage.p95 << ',' << stage.p99 << ',' << stage.max << '\n';
+			}
+		}
+
+		return bool(file);
+	}
+
+	bool write_json(char const * path, settings const & settings, std::vector<scene_result> const & results)
+	{
+		std::ofstream file(path);
+		if (!file)
+			return false;
+
+		file << "{\n  \"instruction_set\": \"" << instruction_set_names[int(active_instruction_set())] << "\",\n  \"width\": " << settings.width << ",\n  \"height\": " << settings.height << ",\n  \"frames\": " << settings.frame_count << ",\n  \"scenes\": [";
+
+		for (std::size_t i = 0; i < results.size(); ++i)
+		{
+			auto const & result = results[i];
+
+			file << (i == 0 ? "\n" : ",\n")
+				<< "    {\n      \"name\": \"" << result.name << "\",\n      \"draws\": " << result.draw_calls << ",\n      \"triangles\": " << result.triangles << ",\n      \"stages\": {";
+
+			for (int s = 0; s < stage_count; ++s)
+			{
+				auto const & stage = result.stages[s];
+				file << (s == 0 ? "\n" : ",\n")
+					<< "        \"" << stage_names[s] << "\": {\"mean_ms\": " << stage.mean << ", \"p50_ms\": " << stage.p50
+					<< ", \"p95_ms\": " << stage.p95 << ", \"p99_ms\": " << stage.p99 << ", \"max_ms\": " << stage.max << "}";
+			}
+
+			auto const & stats = result.stats;
+
+			file << "\n      },\n      \"stats\": {\"clipped_triangles\": " << stats.clipped_triangles
+				<< ", \"clip_rejected_triangles\": " << stats.clip_rejected_triangles
+				<< ", \"culled_triangles\": " << stats.culled_triangles
+				<< ", \"zero_area_triangles\": " << stats.zero_area_triangles
+				<< ", \"rasterized_triangles\": " << stats.rasterized_triangles
+				<< ", \"quads\": " << stats.quads
+				<< ", \"covered_pixels\": " << stats.covered_pixels
+				<< ", \"depth_passed_pixels\": " << stats.depth_passed_pixels
+				<< ", \"shaded_pixels\": " << stats.shaded_pixels
+				<< ", \"quad_efficiency\": " << stats.quad_efficiency();
+
+			for (std::size_t i = 0; i < perf_counter_count; ++i)
+				if (stats.perf.has(perf_counter(i)))
+					file << ", \"" << perf_counter_names[i] << "\": " << stats.perf.values[i];
+
+			file << "}\n    }";
+		}
+
+		file << "\n  ]\n}\n";
+
+		return bool(file);
+	}
+
+	int usage()
+	{
+		std::fprintf(stderr,
+			"usage: tiny-rasterizer-scene-bench [options] [scene...]\n"
+			"  scenes: cubes-10k overdraw tiny-triangles many-lights near-clip (all of these by default),\n"
+			"          or any scene of tiny-rasterizer-headless\n"
+			"  --width W --height H     resolution (800x600)\n"
+			"  --frames N               measured frames per scene (100)\n"
+			"  --warmup N               frames rendered before measuring (5)\n"
+			"  --no-texture             draw untextured\n"
+			"  --perf                   count hardware events in the draws of the stats frame (Linux)\n"
+			"  --csv FILE               write the results as CSV\n"
+			"  --json FILE              write the results as JSON\n");
+		return 1;
+	}
+
+}
+
+int main(int argc, char ** argv)
+{
+	settings settings;
+	std::vector<preset> scenes;
+	bool textured = true;
+	char const * csv_path = nullptr;
+	char const * json_path = nullptr;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string_view argument = argv[i];
+
+		if (argument == "--no-texture")
+			textured = false;
+		else if (argument == "--perf")
+		{
+			if (!enable_perf_counters())
+				std::fprintf(stderr, "Hardware counters are not available\n");
+		}
+		else if (argument == "--width" && i + 1 < argc)
+			settings.width = std::atoi(argv[++i]);
+		else if (argument == "--height" && i + 1 < argc)
+			settings.height = std::atoi(argv[++i]);
+		else if (argument == "--frames" && i + 1 < argc)
+			settings.frame_count = std::atoi(argv[++i]);
+		else if (argument == "--warmup" && i + 1 < argc)
+			settings.warmup_frames = std::atoi(argv[++i]);
+		else if (argument == "--csv" && i + 1 < argc)
+			csv_path = argv[++i];
+		else if (argument == "--json" && i + 1 < argc)
+			json_path = argv[++i];
+		else if (argument.starts_with("--"))
+			return usage();
+		else if (auto preset = find_preset(argument))
+			scenes.push_back(*preset);
+		else
+			return usage();
+	}
+
+	if (settings.width == 0 || settings.height == 0 || settings.frame_count == 0)
+		return usage();
+
+	if (scenes.empty())
+		scenes = presets();
+
+	thread_pool pool;
+
+	texture<color4ub> albedo;
+
+	if (textured)
+	{
+		std::filesystem::path project_root = PROJECT_ROOT;
+		albedo = load_texture_cached(project_root / "assets" / "brick_1024.jpg", std::filesystem::temp_directory_path() / "tiny-rasterizer-cache", &pool);
+
+		if (albedo.mipmaps.empty())
+		{
+			std::fprintf(stderr, "Failed to load the brick texture\n");
+			return 1;
+		}
+
+		for (auto & preset : scenes)
+		{
+			preset.scene.albedo = texture_and_sampler
+			{
+				.texture = &albedo,
+				.sampler = {
+					.mag_filter = filtering::linear,
+					.min_filter = filtering::linear,
+				},
+			};
+		}
+	}
+
+	std::printf("%s kernels\n", instruction_set_names[int(active_instruction_set())]);
+
+	std::vector<scene_result> results;
+
+	for (auto const & preset : scenes)
+	{
+		results.push_back(run(settings, preset));
+		print(results.back());
+	}
+
+	if (csv_path && !write_csv(csv_path, settings, results))
+	{
+		std::fprintf(stderr, "Failed to write %s\n", csv_path);
+		return 1;
+	}
+
+	if (json_path && !write_json(json_path, settings, results))
+	{
+		std::fprintf(stderr, "Failed to write %s\n", json_path);
+		return 1;
+	}
+}
@@ -0,0 +1,432 @@
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+#include <unordered_set>
+
+#include <rasterizer/renderer.hpp>
+#include <rasterizer/image.hpp>
+#include <rasterizer/texture.hpp>
+#include <rasterizer/thread_pool.hpp>
+#include <rasterizer/texture_loader.hpp>
+#include <rasterizer/bounded_queue.hpp>
+#include <rasterizer/trace.hpp>
+#include <rasterizer/capture.hpp>
+#include <rasterizer/telemetry.hpp>
+
+#include "scene.hpp"
+
+using namespace rasterizer;
+
+// Channel order of the surface's pixels in memory, if it is one the renderer can write directly
+std::optional<channel_order> surface_channel_order(SDL_Surface const * surface)
+{
+	switch (surface->format->format)
+	{
+	case SDL_PIXELFORMAT_RGBA32:
+		return channel_order::rgba;
+	case SDL_PIXELFORMAT_BGRA32:
+		return channel_order::bgra;
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+	// Formats with an unused byte where alpha goes, writing alpha there is harmless
+	case SDL_PIXELFORMAT_BGR888:
+		return channel_order::rgba;
+	case SDL_PIXELFORMAT_RGB888:
+		return channel_order::bgra;
+#endif
+	}
+
+	return std::nullopt;
+}
+
+image_view<color4ub> surface_view(SDL_Surface * surface, int width, int height)
+{
+	return image_view<color4ub>
+	{
+		.pixels = (color4ub *)surface->pixels,
+		.width = (std::uint32_t)width,
+		.height = (std::uint32_t)height,
+		.pitch = (std::uint32_t)surface->pitch / sizeof(color4ub),
+	};
+}
+
+// Everything needed to render one frame: the commands recorded for it and the buffers
+// they are rendered to, so that several frames can be in flight at once
+struct frame
+{
+	int width = 0;
+	int height = 0;
+
+	// Tiled, backed by prefaulted huge pages where available, to cut TLB misses
+	image<color4ub> color_buffer;
+	image<std::uint32_t> depth_buffer;
+
+	// Set when color was rendered straight into the window surface
+	bool rendered_to_window = false;
+
+	// Measured by whichever thread rendered the frame, recorded when it is presented
+	float render_milliseconds = 0.f;
+
+	demo::frame_commands commands;
+};
+
+void render(frame & frame, image_view<color4ub> const & color)
+{
+	RASTERIZER_TRACE_ZONE("render");
+
+	auto start = std::chrono::steady_clock::now();
+
+	framebuffer framebuffer
+	{
+		.color = color,
+		.depth = frame.depth_buffer.view(),
+	};
+
+	clear(framebuffer.color, {0.9f, 0.9f, 0.9f, 1.f});
+	clear(framebuffer.depth, 1.f);
+
+	for (auto const & command : frame.commands.commands)
+		draw(framebuffer, frame.commands.viewport, command);
+
+	frame.render_milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	capture::end_frame();
+}
+
+int main(int argc, char ** argv)
+{
+	// Frames being recorded, rendered or presented at the same time, set with --frames-in-flight N
+	// With 1, frames are rendered on the main thread, straight into the window surface when possible;
+	// with more, a render thread rasterizes frame N while the main thread handles events and
+	// records frame N + 1, and presents frame N - 1
+	// By default 1 when the window surface can be rendered to, since there is a single surface
+	// and pipelined frames each need their own buffer, which then costs a copy to present.
+	// Pipelining overlaps recording with rendering instead, which wins when recording is slow
+	int frames_in_flight = 0;
+
+	// Frame & stage times, shown in an overlay toggled with O, and appended every
+	// second to the file given with --telemetry FILE
+	telemetry telemetry;
+	std::unique_ptr<telemetry_exporter> exporter;
+
+	for (int i = 1; i + 1 < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--frames-in-flight") == 0)
+			frames_in_flight = std::max(1, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--telemetry") == 0)
+			exporter = std::make_unique<telemetry_exporter>(argv[++i], std::chrono::seconds(1));
+	}
+
+	auto const frame_series = telemetry.add_series("frame");
+	auto const record_series = telemetry.add_series("record");
+	auto const render_series = telemetry.add_series("render");
+	auto const present_series = telemetry.add_series("present");
+
+	bool show_overlay = true;
+
+	SDL_Init(SDL_INIT_VIDEO);
+
+	trace::set_thread_name("main");
+
+	int width = 800;
+	int height = 600;
+
+	SDL_Window * window = SDL_CreateWindow("Tiny rasterizer", 0*SDL_WINDOWPOS_UNDEFINED, 0*SDL_WINDOWPOS_UNDEFINED, width, height, 0*SDL_WINDOW_RESIZABLE | SDL_WINDOW_SHOWN);
+
+	if (frames_in_flight == 0)
+		frames_in_flight = surface_channel_order(SDL_GetWindowSurface(window)) == channel_order::rgba ? 1 : 2;
+
+	// Only used when the window surface has a format that copy() can't write
+	SDL_Surface * draw_surface = nullptr;
+
+	int mouse_x = 0;
+	int mouse_y = 0;
+
+	std::filesystem::path project_root = PROJECT_ROOT;
+
+	using namespace rasterizer;
+
+	thread_pool pool;
+
+	auto texture_cache = std::filesystem::temp_directory_path() / "tiny-rasterizer-cache";
+
+	// Rendering starts right away with a placeholder, the texture is swapped in once loaded
+	texture<color4ub> placeholder_texture = make_checkerboard_texture({255, 0, 255, 255}, {32, 32, 32, 255});
+
+	texture_handle brick_texture = load_texture_async(project_root / "assets" / "brick_1024.jpg", pool, {.cache_directory = texture_cache});
+
+	float cube_angle = 0.f;
+	float cube_distance = 5.f;
+
+	std::unordered_set<SDL_Keycode> keydown;
+
+	// Frames not in flight are only ever touched by the main thread
+	std::vector<std::unique_ptr<frame>> frames;
+	std::vector<frame *> free_frames;
+
+	for (int i = 0; i < frames_in_flight; ++i)
+		free_frames.push_back(frames.emplace_back(std::make_unique<frame>()).get());
+
+	bounded_queue<frame *> recorded_frames(frames_in_flight);
+	bounded_queue<frame *> rendered_frames(frames_in_flight);
+
+	std::thread render_thread;
+
+	if (frames_in_flight > 1)
+	{
+		render_thread = std::thread([&]{
+			trace::set_thread_name("render");
+
+			while (auto frame = recorded_frames.pop())
+			{
+				render(**frame, (*frame)->color_buffer.view());
+				rendered_frames.push(*frame);
+			}
+		});
+	}
+
+	auto present = [&](frame & frame)
+	{
+		RASTERIZER_TRACE_ZONE("present");
+
+		// Frames recorded before a resize are dropped
+		if (frame.width != width || frame.height != height)
+			return;
+
+		auto start = std::chrono::steady_clock::now();
+
+		telemetry.record(render_series, frame.render_milliseconds);
+
+		SDL_Surface * window_surface = SDL_GetWindowSurface(window);
+
+		if (show_overlay)
+		{
+			if (frame.rendered_to_window)
+			{
+				if (SDL_MUSTLOCK(window_surface))
+					SDL_LockSurface(window_surface);
+
+				draw_overlay(telemetry, surface_view(window_surface, width, height));
+
+				if (SDL_MUSTLOCK(window_surface))
+					SDL_UnlockSurface(window_surface);
+			}
+			else
+				draw_overlay(telemetry, frame.color_buffer.view());
+		}
+
+		if (auto order = surface_channel_order(window_surface))
+		{
+			if (!frame.rendered_to_window)
+			{
+				if (SDL_MUSTLOCK(window_surface))
+					SDL_LockSurface(window_surface);
+
+				copy(frame.color_buffer.view(), surface_view(window_surface, width, height), *order);
+
+				if (SDL_MUSTLOCK(window_surface))
+					SDL_UnlockSurface(window_surface);
+			}
+		}
+		else
+		{
+			if (!draw_surface)
+			{
+				draw_surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+				SDL_SetSurfaceBlendMode(draw_surface, SDL_BLENDMODE_NONE);
+			}
+
+			copy(frame.color_buffer.view(), surface_view(draw_surface, width, height));
+
+			SDL_Rect rect{.x = 0, .y = 0, .w = width, .h = height};
+			SDL_BlitSurface(draw_surface, &rect, window_surface, &rect);
+		}
+
+		SDL_UpdateWindowSurface(window);
+
+		telemetry.record(present_series, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+	};
+
+	using clock = std::chrono::high_resolution_clock;
+
+	auto last_frame_start = clock::now();
+
+	bool running = true;
+	while (running)
+	{
+		for (SDL_Event event; SDL_PollEvent(&event);) switch (event.type)
+		{
+		case SDL_WINDOWEVENT:
+			switch (event.window.event)
+			{
+			case SDL_WINDOWEVENT_RESIZED:
+				if (draw_surface)
+					SDL_FreeSurface(draw_surface);
+				draw_surface = nullptr;
+				width = event.window.data1;
+				height = event.window.data2;
+				break;
+			}
+			break;
+		case SDL_QUIT:
+			running = false;
+			break;
+		case SDL_MOUSEMOTION:
+			mouse_x = event.motion.x;
+			mouse_y = event.motion.y;
+			break;
+		case SDL_KEYDOWN:
+			keydown.insert(event.key.keysym.sym);
+
+			if (event.key.keysym.sym == SDLK_o && !event.key.repeat)
+				show_overlay = !show_overlay;
+
+			// Dumps the last few seconds of zones, when built with RASTERIZER_TRACE
+			if (event.key.keysym.sym == SDLK_t && !event.key.repeat)
+			{
+				if (trace::write_chrome_trace("tiny-rasterizer-trace.json"))
+					std::cout << "Wrote tiny-rasterizer-trace.json" << std::endl;
+				else
+					std::cerr << "Failed to write tiny-rasterizer-trace.json" << std::endl;
+			}
+
+			// Starts or stops recording draws for tiny-rasterizer-replay
+			if (event.key.keysym.sym == SDLK_c && !event.key.repeat)
+			{
+				if (capture::active())
+				{
+					capture::stop();
+					std::cout << "Wrote tiny-rasterizer.capture" << std::endl;
+				}
+				else if (capture::start("tiny-rasterizer.capture"))
+					std::cout << "Capturing to tiny-rasterizer.capture" << std::endl;
+				else
+					std::cerr << "Failed to write tiny-rasterizer.capture" << std::endl;
+			}
+			break;
+		case SDL_KEYUP:
+			keydown.erase(event.key.keysym.sym);
+			break;
+		}
+
+		if (!running)
+			break;
+
+		auto now = clock::now();
+		float dt = std::chrono::duration_cast<std::chrono::duration<float>>(now - last_frame_start).count();
+		last_frame_start = now;
+
+		telemetry.record(frame_series, dt * 1000.f);
+
+		if (exporter)
+			exporter->update(telemetry);
+
+		if (keydown.contains(SDLK_LEFT))
+			cube_angle -= 2.f * dt;
+		if (keydown.contains(SDLK_RIGHT))
+			cube_angle += 2.f * dt;
+
+		if (keydown.contains(SDLK_UP))
+			cube_distance += 4.f * dt;
+		if (keydown.contains(SDLK_DOWN))
+			cube_distance -= 4.f * dt;
+
+		// Present whatever finished rendering, and only wait for the
+		// oldest frame in flight when there is no free frame to record
+		while (auto rendered = rendered_frames.try_pop())
+		{
+			present(**rendered);
+			free_frames.push_back(*rendered);
+		}
+
+		frame * frame;
+
+		if (!free_frames.empty())
+		{
+			frame = free_frames.back();
+			free_frames.pop_back();
+		}
+		else
+		{
+			frame = *rendered_frames.pop();
+			present(*frame);
+		}
+
+		if (frame->width != width || frame->height != height)
+		{
+			frame->width = width;
+			frame->height = height;
+			frame->color_buffer = {};
+			frame->depth_buffer = image<std::uint32_t>::allocate(width, height, {.layout = image_layout::tiled, .memory = {.huge_pages = true, .prefault = true}});
+		}
+
+		demo::scene_settings scene
+		{
+			.albedo = texture_and_sampler {
+				.texture = brick_texture.get(&placeholder_texture),
+				.sampler = {
+					.mag_filter = filtering::linear,
+					.min_filter = filtering::linear,
+				},
+			},
+		};
+
+		{
+			RASTERIZER_TRACE_ZONE("record");
+
+			auto record_start = clock::now();
+			demo::record(scene, {.angle = cube_angle, .distance = cube_distance}, width, height, frame->commands);
+			telemetry.record(record_series, std::chrono::duration<float, std::milli>(clock::now() - record_start).count());
+		}
+
+		if (render_thread.joinable())
+		{
+			if (!frame->color_buffer)
+				frame->color_buffer = image<color4ub>::allocate(width, height, {.layout = image_layout::tiled, .memory = {.huge_pages = true, .prefault = true}});
+
+			frame->rendered_to_window = false;
+			recorded_frames.push(frame);
+			continue;
+		}
+
+		// Serial path: render into the window surface if it is RGBA, otherwise into the
+		// frame's own buffer, which is detiled (and swizzled if needed) into it when presenting
+		SDL_Surface * window_surface = SDL_GetWindowSurface(window);
+		frame->rendered_to_window = surface_channel_order(window_surface) == channel_order::rgba;
+
+		if (frame->rendered_to_window)
+		{
+			frame->color_buffer = {};
+
+			if (SDL_MUSTLOCK(window_surface))
+				SDL_LockSurface(window_surface);
+
+			render(*frame, surface_view(window_surface, width, height));
+
+			if (SDL_MUSTLOCK(window_surface))
+				SDL_UnlockSurface(window_surface);
+		}
+		else
+		{
+			if (!frame->color_buffer)
+				frame->color_buffer = image<color4ub>::allocate(width, height, {.layout = image_layout::tiled, .memory = {.huge_pages = true, .prefault = true}});
+
+			render(*frame, frame->color_buffer.view());
+		}
+
+		present(*frame);
+		free_frames.push_back(frame);
+	}
+
+	recorded_frames.close();
+	if (render_thread.joinable())
+		render_thread.join();
+
+	capture::stop();
+}
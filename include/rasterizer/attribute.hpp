@@ -1,19 +1,334 @@
 #pragma once
 
+#include <rasterizer/vector.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
 
 namespace rasterizer
 {
 
+	// How the elements of an attribute are stored; every format decodes to the attribute's
+	// float vector type when read
+	enum class attribute_format : std::uint8_t
+	{
+		// The vector type itself
+		float32,
+
+		// An IEEE half float per component
+		float16,
+
+		// A byte per component, 0 to 255 mapping to [0, 1], e.g. color4ub colors
+		unorm8,
+
+		// vector3f unit vectors only: the octahedral mapping of the sphere onto a square,
+		// stored as two signed 16-bit normalized values; decoded vectors are normalized
+		octahedral_snorm16,
+	};
+
+	// Bytes per element of an attribute of T, the smallest valid stride
+	template <typename T>
+	constexpr std::uint32_t attribute_size(attribute_format format)
+	{
+		constexpr std::uint32_t components = sizeof(T) / sizeof(float);
+
+		switch (format)
+		{
+		case attribute_format::float32: return sizeof(T);
+		case attribute_format::float16: return components * 2;
+		case attribute_format::unorm8: return components;
+		case attribute_format::octahedral_snorm16: return 4;
+		}
+
+		return sizeof(T);
+	}
+
+	// Exact for every half, including subnormals, infinities and NaNs
+	inline float half_to_float(std::uint16_t half)
+	{
+		// Shifting puts the exponent and mantissa in place, then the exponent is rebiased from
+		// 15 to 127; subnormals are decoded as 1.mantissa * 2^-14 minus 2^-14 rather than by
+		// multiplying, which would take a denormal operand and be many times slower
+		std::uint32_t bits = std::uint32_t(half & 0x7fff) << 13;
+		std::uint32_t exponent = bits & (0x7c00 << 13);
+
+		bits += 112u << 23;
+
+		float result;
+		if (exponent == (0x7c00 << 13))
+			result = std::bit_cast<float>(bits + (112u << 23));
+		else if (exponent == 0)
+			result = std::bit_cast<float>(bits + (1u << 23)) - std::bit_cast<float>(113u << 23);
+		else
+			result = std::bit_cast<float>(bits);
+
+		return std::bit_cast<float>(std::bit_cast<std::uint32_t>(result) | (std::uint32_t(half & 0x8000) << 16));
+	}
+
+	// Rounds to nearest even, out of range values become infinities
+	inline std::uint16_t float_to_half(float value)
+	{
+		std::uint32_t bits = std::bit_cast<std::uint32_t>(value);
+		std::uint32_t sign = (bits >> 16) & 0x8000;
+		std::uint32_t magnitude = bits & 0x7fffffff;
+
+		// NaN, then anything that rounds past 65504
+		if (magnitude > 0x7f800000)
+			return sign | 0x7e00;
+		if (magnitude >= 0x477ff000)
+			return sign | 0x7c00;
+
+		// Below 2^-14 the result is subnormal: adding 0.5 makes the float addition round
+		// the mantissa at the half's last bit
+		if (magnitude < 0x38800000)
+			return sign | (std::bit_cast<std::uint32_t>(std::bit_cast<float>(magnitude) + 0.5f) - 0x3f000000);
+
+		std::uint32_t rounded = magnitude - (112u << 23) + 0xfff + ((magnitude >> 13) & 1);
+		return sign | (rounded >> 13);
+	}
+
+	// Normals have to be unit length
+	inline std::array<std::int16_t, 2> encode_octahedral_snorm16(vector3f const & normal)
+	{
+		float scale = 1.f / (std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z));
+		float x = normal.x * scale;
+		float y = normal.y * scale;
+
+		// The lower hemisphere folds over the diagonals
+		if (normal.z < 0.f)
+		{
+			float folded_x = (1.f - std::abs(y)) * (x >= 0.f ? 1.f : -1.f);
+			float folded_y = (1.f - std::abs(x)) * (y >= 0.f ? 1.f : -1.f);
+			x = folded_x;
+			y = folded_y;
+		}
+
+		return {std::int16_t(std::lround(x * 32767.f)), std::int16_t(std::lround(y * 32767.f))};
+	}
+
+	namespace detail
+	{
+
+		template <std::size_t N>
+		std::array<float, N> first(float const (&values)[4])
+		{
+			std::array<float, N> result;
+			std::memcpy(result.data(), values, sizeof(result));
+			return result;
+		}
+
+		// The bytes of an element, zero above: they're loaded in power of 2 sized pieces and
+		// assembled in a register, copying them to memory and loading that back in one go
+		// would stall store forwarding
+		template <std::size_t Size>
+		std::uint64_t load_bits(char const * element)
+		{
+			constexpr std::size_t head = std::bit_floor(Size);
+			using head_type = std::conditional_t<head == 8, std::uint64_t, std::conditional_t<head == 4, std::uint32_t, std::conditional_t<head == 2, std::uint16_t, std::uint8_t>>>;
+
+			head_type bits;
+			std::memcpy(&bits, element, head);
+
+			if constexpr (head == Size)
+				return bits;
+			else
+				return bits | (load_bits<Size - head>(element + head) << (8 * head));
+		}
+
+#if defined(__SSE2__)
+		template <std::size_t Size>
+		__m128i load_low(char const * element)
+		{
+#if defined(__x86_64__)
+			return _mm_cvtsi64_si128(load_bits<Size>(element));
+#else
+			return _mm_set_epi64x(0, load_bits<Size>(element));
+#endif
+		}
+#endif
+
+		template <std::size_t N>
+		std::array<float, N> decode_float16(char const * element)
+		{
+			float values[4];
+
+#if defined(__F16C__)
+			_mm_storeu_ps(values, _mm_cvtph_ps(load_low<N * 2>(element)));
+#elif defined(__SSE2__)
+			// half_to_float on 4 lanes, with masks instead of branches
+			__m128i half = _mm_unpacklo_epi16(load_low<N * 2>(element), _mm_setzero_si128());
+			__m128i bits = _mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x7fff)), 13);
+			__m128i exponent = _mm_and_si128(bits, _mm_set1_epi32(0x7c00 << 13));
+			__m128i infinite = _mm_cmpeq_epi32(exponent, _mm_set1_epi32(0x7c00 << 13));
+			__m128i subnormal = _mm_cmpeq_epi32(exponent, _mm_setzero_si128());
+
+			bits = _mm_add_epi32(bits, _mm_set1_epi32(112 << 23));
+			bits = _mm_add_epi32(bits, _mm_and_si128(infinite, _mm_set1_epi32(112 << 23)));
+			bits = _mm_add_epi32(bits, _mm_and_si128(subnormal, _mm_set1_epi32(1 << 23)));
+
+			__m128 result = _mm_sub_ps(_mm_castsi128_ps(bits), _mm_and_ps(_mm_castsi128_ps(subnormal), _mm_castsi128_ps(_mm_set1_epi32(113 << 23))));
+			__m128i sign = _mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x8000)), 16);
+			_mm_storeu_ps(values, _mm_or_ps(result, _mm_castsi128_ps(sign)));
+#else
+			std::uint16_t halves[4] = {};
+			std::memcpy(halves, element, N * 2);
+
+			for (std::size_t i = 0; i < 4; ++i)
+				values[i] = half_to_float(halves[i]);
+#endif
+
+			return first<N>(values);
+		}
+
+		template <std::size_t N>
+		std::array<float, N> decode_unorm8(char const * element)
+		{
+			float values[4];
+
+#if defined(__SSE2__)
+			// Divides like the unorm8_to_float table, so color4ub colors decode to the same values
+			__m128i const zero = _mm_setzero_si128();
+			__m128i integers = _mm_unpacklo_epi16(_mm_unpacklo_epi8(load_low<N>(element), zero), zero);
+			_mm_storeu_ps(values, _mm_div_ps(_mm_cvtepi32_ps(integers), _mm_set1_ps(255.f)));
+#else
+			std::uint8_t bytes[4] = {};
+			std::memcpy(bytes, element, N);
+
+			for (std::size_t i = 0; i < 4; ++i)
+				values[i] = bytes[i] / 255.f;
+#endif
+
+			return first<N>(values);
+		}
+
+		inline vector3f decode_octahedral_snorm16(char const * element)
+		{
+#if defined(__SSE2__)
+			// The same steps as below on (x, y, z, 0); lane operations keep the lower hemisphere's
+			// unpredictable branches out
+			__m128 const sign_bit = _mm_set1_ps(-0.f);
+
+			__m128i snorm = _mm_srai_epi32(_mm_unpacklo_epi16(_mm_setzero_si128(), load_low<4>(element)), 16);
+			__m128 v = _mm_max_ps(_mm_div_ps(_mm_cvtepi32_ps(snorm), _mm_set1_ps(32767.f)), _mm_set_ps(0.f, 0.f, -1.f, -1.f));
+
+			__m128 magnitude = _mm_andnot_ps(sign_bit, v);
+			__m128 z = _mm_sub_ss(_mm_sub_ss(_mm_set_ss(1.f), magnitude), _mm_shuffle_ps(magnitude, magnitude, _MM_SHUFFLE(1, 1, 1, 1)));
+
+			__m128 t = _mm_max_ps(_mm_xor_ps(_mm_shuffle_ps(z, z, _MM_SHUFFLE(0, 0, 0, 0)), sign_bit), _mm_setzero_ps());
+			v = _mm_add_ps(v, _mm_or_ps(t, _mm_andnot_ps(v, sign_bit)));
+			v = _mm_movelh_ps(v, z);
+
+			__m128 square = _mm_mul_ps(v, v);
+			__m128 length = _mm_sqrt_ss(_mm_add_ss(_mm_add_ss(square, _mm_shuffle_ps(square, square, _MM_SHUFFLE(1, 1, 1, 1))), _mm_movehl_ps(square, square)));
+
+			float values[4];
+			_mm_storeu_ps(values, _mm_div_ps(v, _mm_shuffle_ps(length, length, _MM_SHUFFLE(0, 0, 0, 0))));
+			return {values[0], values[1], values[2]};
+#else
+			std::int16_t values[2];
+			std::memcpy(values, element, sizeof(values));
+
+			// -32768 decodes like -32767, to exactly -1
+			float x = std::max(values[0] / 32767.f, -1.f);
+			float y = std::max(values[1] / 32767.f, -1.f);
+			float z = 1.f - std::abs(x) - std::abs(y);
+
+			// Unfolds the lower hemisphere
+			float t = std::max(-z, 0.f);
+			x += std::copysign(t, -x);
+			y += std::copysign(t, -y);
+
+			return normalized(vector3f{x, y, z});
+#endif
+		}
+
+	}
+
+	// Calls f(std::integral_constant<attribute_format, format>{}) for an attribute of T, so that
+	// code reading many elements, e.g. a draw, can resolve the format once and then decode with
+	// decode_attribute<T, Format>
+	// octahedral_snorm16 attributes of other types than vector3f are invalid: they assert, or
+	// read as float32 when asserts are compiled out
+	template <typename T, typename F>
+	decltype(auto) visit_format(attribute_format format, F && f)
+	{
+		switch (format)
+		{
+		case attribute_format::float32:
+			break;
+		case attribute_format::float16:
+			return f(std::integral_constant<attribute_format, attribute_format::float16>{});
+		case attribute_format::unorm8:
+			return f(std::integral_constant<attribute_format, attribute_format::unorm8>{});
+		case attribute_format::octahedral_snorm16:
+			if constexpr (sizeof(T) == sizeof(vector3f))
+				return f(std::integral_constant<attribute_format, attribute_format::octahedral_snorm16>{});
+			else
+				assert(!"octahedral_snorm16 is for vector3f attributes only");
+			break;
+		}
+
+		return f(std::integral_constant<attribute_format, attribute_format::float32>{});
+	}
+
+	// One element, stored in Format
+	template <typename T, attribute_format Format>
+	T decode_attribute(char const * element)
+	{
+		constexpr std::size_t components = sizeof(T) / sizeof(float);
+
+		if constexpr (Format == attribute_format::float16)
+			return std::bit_cast<T>(detail::decode_float16<components>(element));
+		else if constexpr (Format == attribute_format::unorm8)
+			return std::bit_cast<T>(detail::decode_unorm8<components>(element));
+		else if constexpr (Format == attribute_format::octahedral_snorm16)
+		{
+			static_assert(components == 3, "octahedral_snorm16 is for vector3f attributes only");
+			return std::bit_cast<T>(detail::decode_octahedral_snorm16(element));
+		}
+		else
+		{
+			T result;
+			std::memcpy(&result, element, sizeof(T));
+			return result;
+		}
+	}
+
+	// A float vector per vertex, read from pointer + stride * index, in bytes
+	// A stride of 0 repeats one value for every vertex
 	template <typename T>
 	struct attribute
 	{
+		static_assert(sizeof(T) % sizeof(float) == 0 && sizeof(T) <= 4 * sizeof(float), "attributes are vectors of up to 4 floats");
+
 		void const * pointer = nullptr;
 		std::uint32_t stride = sizeof(T);
+		attribute_format format = attribute_format::float32;
 
-		T const & operator[] (std::uint32_t i) const
+		// Decoded, so returned by value; switches over the format on every call, see
+		// visit_format to read many elements
+		T operator[] (std::uint32_t i) const
 		{
-			return *(T const *)((char const *)(pointer) + stride * i);
+			char const * element = (char const *)(pointer) + stride * i;
+
+			return visit_format<T>(format, [element]<attribute_format Format>(std::integral_constant<attribute_format, Format>)
+			{
+				return decode_attribute<T, Format>(element);
+			});
 		}
 	};
 
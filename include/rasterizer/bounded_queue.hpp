@@ -0,0 +1,91 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace rasterizer
+{
+
+	// FIFO for handing work from one thread to another, push blocks while it is full
+	// After close(), pop returns the remaining items and then nothing
+
+	template <typename T>
+	struct bounded_queue
+	{
+		explicit bounded_queue(std::size_t capacity)
+			: capacity(capacity)
+		{}
+
+		// Returns false if the queue was closed, in which case value is dropped
+		bool push(T value)
+		{
+			std::unique_lock lock{mutex};
+			not_full.wait(lock, [this]{ return items.size() < capacity || closed; });
+
+			if (closed)
+				return false;
+
+			items.push_back(std::move(value));
+			not_empty.notify_one();
+			return true;
+		}
+
+		// Never blocks: returns false, dropping value, if the queue is full or closed
+		bool try_push(T value)
+		{
+			std::lock_guard lock{mutex};
+
+			if (closed || items.size() >= capacity)
+				return false;
+
+			items.push_back(std::move(value));
+			not_empty.notify_one();
+			return true;
+		}
+
+		// Blocks until an item is available or the queue is closed and empty
+		std::optional<T> pop()
+		{
+			std::unique_lock lock{mutex};
+			not_empty.wait(lock, [this]{ return !items.empty() || closed; });
+			return take();
+		}
+
+		std::optional<T> try_pop()
+		{
+			std::lock_guard lock{mutex};
+			return take();
+		}
+
+		void close()
+		{
+			std::lock_guard lock{mutex};
+			closed = true;
+			not_empty.notify_all();
+			not_full.notify_all();
+		}
+
+		std::size_t capacity;
+		std::mutex mutex;
+		std::condition_variable not_empty;
+		std::condition_variable not_full;
+		std::deque<T> items;
+		bool closed = false;
+
+		// mutex must be held
+		std::optional<T> take()
+		{
+			if (items.empty())
+				return std::nullopt;
+
+			std::optional<T> result{std::move(items.front())};
+			items.pop_front();
+			not_full.notify_one();
+			return result;
+		}
+	};
+
+}
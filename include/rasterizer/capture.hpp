@@ -0,0 +1,69 @@
+#pragma once
+
+#include <rasterizer/renderer.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+// Capture of every clear & draw call made while a capture is active, into a file that a replay
+// re-executes headless on buffers of its own, so that rendering problems can be reproduced and
+// profiled without the application or its assets
+//
+// Everything a call reads is stored: buffer formats & sizes, the viewport, the whole draw_command,
+// its vertex attributes & indices, lights and textures. Vertex data, indices and textures are
+// written once per distinct content, identified by a hash; textures are hashed the first time
+// they're drawn with and assumed to stay unchanged afterwards
+// Heatmaps & render_stats aren't captured
+
+namespace rasterizer::capture
+{
+
+	// Starts writing to the file, finishing any capture in progress first
+	// Returns false if the file couldn't be opened
+	bool start(std::filesystem::path const & path);
+
+	// Finishes the capture in progress, if any
+	void stop();
+
+	bool active();
+
+	// Marks the end of a frame: replays time & run each frame separately
+	void end_frame();
+
+	// Called by clear() & draw() while a capture is active
+	// Depth clears are stored as the raw value in the buffer's encoding, floats as their bits
+	void record_clear(image_view<color4ub> const & color_buffer, vector4f const & color);
+	void record_clear(depth_view const & depth_buffer, std::uint32_t raw_value);
+	void record_draw(framebuffer const & framebuffer, viewport const & viewport, draw_command const & command);
+
+	// A loaded capture, replayed into buffers allocated to match the recorded ones
+	struct replay
+	{
+		struct state;
+
+		std::shared_ptr<state> data;
+
+		explicit operator bool() const
+		{
+			return data != nullptr;
+		}
+
+		// Complete frames only: calls after the last end_frame() are discarded as a frame cut short
+		std::size_t frame_count() const;
+
+		std::size_t draw_count(std::size_t frame) const;
+
+		// Re-executes the clears & draws of a frame, collecting stats as draw() does
+		void play(std::size_t frame, render_stats * stats = nullptr) const;
+
+		// Color buffers drawn to, in the order they first appear in the capture
+		std::size_t color_buffer_count() const;
+		image_view<color4ub> color_buffer(std::size_t index) const;
+
+		// Returns an empty replay if the file is missing, not a capture or has no complete frame;
+		// frames past a truncated or malformed record are dropped
+		static replay load(std::filesystem::path const & path);
+	};
+
+}
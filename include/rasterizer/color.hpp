@@ -1,10 +1,18 @@
 #pragma once
 
 #include <rasterizer/vector.hpp>
+#include <rasterizer/image_view.hpp>
 
+#include <array>
 #include <cstdint>
+#include <cstddef>
+#include <cstring>
 #include <cmath>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace rasterizer
 {
 
@@ -27,8 +35,27 @@ namespace rasterizer
 		return (a > b) ? b : a;
 	}
 
+	// Channel value to [0, 1] float tables, the second one decodes sRGB to linear
+
+	extern std::array<float, 256> const unorm8_to_float;
+	extern std::array<float, 256> const srgb8_to_linear;
+
 	inline color4ub to_color4ub(vector4f const & c)
 	{
+#if defined(__SSE2__)
+		// Same clamping as the scalar path, including NaN -> 255
+		__m128 v = _mm_mul_ps(_mm_loadu_ps(&c.x), _mm_set1_ps(255.f));
+		v = _mm_max_ps(_mm_min_ps(v, _mm_set1_ps(255.f)), _mm_setzero_ps());
+
+		__m128i i = _mm_cvttps_epi32(v);
+		i = _mm_packs_epi32(i, i);
+		i = _mm_packus_epi16(i, i);
+
+		color4ub result;
+		std::uint32_t bits = _mm_cvtsi128_si32(i);
+		std::memcpy(&result, &bits, sizeof(result));
+		return result;
+#else
 		color4ub result;
 
 		result.r = max(0.f, min(255.f, c.x * 255.f));
@@ -37,11 +64,31 @@ namespace rasterizer
 		result.a = max(0.f, min(255.f, c.w * 255.f));
 
 		return result;
+#endif
 	}
 
 	inline vector4f to_vector4f(color4ub const & c)
 	{
-		return vector4f{c.r, c.g, c.b, c.a} / 255.f;
+		return {unorm8_to_float[c.r], unorm8_to_float[c.g], unorm8_to_float[c.b], unorm8_to_float[c.a]};
 	}
 
+	// Decodes RGB from sRGB, alpha is always linear
+	inline vector4f to_vector4f_srgb(color4ub const & c)
+	{
+		return {srgb8_to_linear[c.r], srgb8_to_linear[c.g], srgb8_to_linear[c.b], unorm8_to_float[c.a]};
+	}
+
+	// Bulk conversions, vectorized where possible
+	// Results are identical to converting one pixel at a time
+
+	void to_vector4f(color4ub const * source, vector4f * destination, std::size_t count);
+	void to_vector4f_srgb(color4ub const * source, vector4f * destination, std::size_t count);
+	void to_color4ub(vector4f const * source, color4ub * destination, std::size_t count);
+
+	// Image views must have the same size, their layouts can differ
+
+	void convert(image_view<color4ub> const & source, image_view<vector4f> const & destination);
+	void convert_srgb(image_view<color4ub> const & source, image_view<vector4f> const & destination);
+	void convert(image_view<vector4f> const & source, image_view<color4ub> const & destination);
+
 }
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <rasterizer/image.hpp>
+#include <rasterizer/memory.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace rasterizer
+{
+
+	// Depth as a function of window coordinates: a * x + b * y + c, evaluated at pixel centers
+	struct depth_plane
+	{
+		float a = 0.f;
+		float b = 0.f;
+		float c = 0.f;
+
+		bool operator == (depth_plane const &) const = default;
+	};
+
+	// Every stored depth goes through this function, so storing a plane is
+	// exactly as precise as storing the values it evaluates to
+	inline float evaluate(depth_plane const & plane, std::uint32_t x, std::uint32_t y)
+	{
+		return plane.a * (x + 0.5f) + plane.b * (y + 0.5f) + plane.c;
+	}
+
+	enum class depth_tile_mode : std::uint8_t
+	{
+		// Every pixel uses planes[0]
+		one_plane,
+
+		// Pixels with their bit set in mask use planes[1], others use planes[0]
+		two_planes,
+
+		// Depth is stored per pixel
+		// planes[0] is the last plane written, and mask tells which pixels hold its values,
+		// so that a tile goes back to one plane once a triangle covers it entirely
+		full,
+	};
+
+	// Depth of one tile_size x tile_size tile, 48 bytes instead of 256, plus 256 bytes
+	// of per-pixel storage once the tile has needed it
+	struct depth_tile
+	{
+		depth_plane planes[2];
+
+		// Bit (x % tile_size) + (y % tile_size) * tile_size for pixel (x, y)
+		std::uint64_t mask;
+
+		depth_tile_mode mode;
+
+		// tile_size * tile_size depths, indexed like mask bits
+		// Taken from the pool the first time the tile goes full, and kept across clears
+		float * pixels;
+	};
+
+	// Per-pixel storage of the tiles that went full, allocated in chunks as they first do
+	// Memory grows to the most tiles any frame needed it for: scenes with few depth
+	// discontinuities stay well below a D32 buffer, the worst case is ~20% above it
+	struct depth_pixel_pool
+	{
+		memory_options memory = {};
+		std::vector<std::shared_ptr<void>> chunks = {};
+
+		// Blocks handed out from the last chunk
+		std::uint32_t used = 0;
+
+		// tile_size * tile_size floats, never returned to the pool
+		float * allocate();
+
+		std::size_t memory_size() const;
+	};
+
+	struct compressed_depth_view;
+
+	// Switches a tile to per-pixel storage, filling it from its planes
+	void decompress(compressed_depth_view const & view, depth_tile & tile, std::uint32_t x, std::uint32_t y);
+
+	// Losslessly compressed normalized depth in [0, 1], the far plane being 1
+	// Tiles start as a single plane and only get per-pixel storage once a third
+	// plane is written to them. Drawing isn't thread-safe, since it may allocate
+	struct compressed_depth_view
+	{
+		// One per tile, linear layout
+		image_view<depth_tile> tiles;
+
+		depth_pixel_pool * pool = nullptr;
+
+		std::uint32_t width = 0;
+		std::uint32_t height = 0;
+
+		explicit operator bool() const
+		{
+			return bool(tiles);
+		}
+
+		// Tile containing pixel (x, y)
+		depth_tile & tile_at(std::uint32_t x, std::uint32_t y) const
+		{
+			return tiles.at(x / tile_size, y / tile_size);
+		}
+
+		// Mask of the pixels of the tile containing (x, y) that are inside the view
+		std::uint64_t tile_mask(std::uint32_t x, std::uint32_t y) const
+		{
+			std::uint32_t const columns = std::min(tile_size, width - x / tile_size * tile_size);
+			std::uint32_t const rows = std::min(tile_size, height - y / tile_size * tile_size);
+
+			std::uint64_t const row = (std::uint64_t(1) << columns) - 1;
+
+			std::uint64_t result = 0;
+			for (std::uint32_t i = 0; i < rows; ++i)
+				result |= row << (i * tile_size);
+			return result;
+		}
+
+		float load(depth_tile const & tile, std::uint32_t x, std::uint32_t y) const
+		{
+			switch (tile.mode)
+			{
+			case depth_tile_mode::one_plane:
+				return evaluate(tile.planes[0], x, y);
+			case depth_tile_mode::two_planes:
+				return evaluate(tile.planes[(tile.mask >> ((x % tile_size) + (y % tile_size) * tile_size)) & 1], x, y);
+			case depth_tile_mode::full:
+				return tile.pixels[(x % tile_size) + (y % tile_size) * tile_size];
+			}
+
+			// Unreachable
+			return 1.f;
+		}
+
+		// Sets the depth of pixel (x, y) to the value of plane
+		void store(depth_tile & tile, std::uint32_t x, std::uint32_t y, depth_plane const & plane) const
+		{
+			std::uint64_t const bit = std::uint64_t(1) << ((x % tile_size) + (y % tile_size) * tile_size);
+
+			switch (tile.mode)
+			{
+			case depth_tile_mode::one_plane:
+				if (plane == tile.planes[0])
+					return;
+				tile.planes[1] = plane;
+				tile.mask = bit;
+				tile.mode = depth_tile_mode::two_planes;
+				return;
+			case depth_tile_mode::two_planes:
+				if (plane == tile.planes[0])
+					tile.mask &= ~bit;
+				else if (plane == tile.planes[1])
+					tile.mask |= bit;
+				else
+				{
+					decompress(*this, tile, x, y);
+					store(tile, x, y, plane);
+					return;
+				}
+
+				// Go back to one plane once the other one isn't used anymore
+				if (tile.mask == 0)
+					tile.mode = depth_tile_mode::one_plane;
+				else if (tile.mask == tile_mask(x, y))
+				{
+					tile.planes[0] = tile.planes[1];
+					tile.mode = depth_tile_mode::one_plane;
+				}
+				return;
+			case depth_tile_mode::full:
+				tile.pixels[(x % tile_size) + (y % tile_size) * tile_size] = evaluate(plane, x, y);
+
+				if (plane == tile.planes[0])
+					tile.mask |= bit;
+				else
+				{
+					tile.planes[0] = plane;
+					tile.mask = bit;
+				}
+
+				if (tile.mask == tile_mask(x, y))
+					tile.mode = depth_tile_mode::one_plane;
+				return;
+			}
+		}
+
+		float at(std::uint32_t x, std::uint32_t y) const
+		{
+			return load(tile_at(x, y), x, y);
+		}
+	};
+
+	// Copies share the tiles and their per-pixel storage
+	struct compressed_depth_buffer
+	{
+		image<depth_tile> tiles;
+		std::shared_ptr<depth_pixel_pool> pool;
+		std::uint32_t width = 0;
+		std::uint32_t height = 0;
+
+		explicit operator bool() const
+		{
+			return bool(tiles);
+		}
+
+		compressed_depth_view view() const
+		{
+			return compressed_depth_view
+			{
+				.tiles = tiles.view(),
+				.pool = pool.get(),
+				.width = width,
+				.height = height,
+			};
+		}
+
+		// Tile records and the per-pixel storage allocated so far
+		std::size_t memory_size() const
+		{
+			return std::size_t(tiles.pitch) * tiles.height * sizeof(depth_tile) + pool->memory_size();
+		}
+
+		// Starts cleared to the far plane, with no per-pixel storage
+		static compressed_depth_buffer allocate(std::uint32_t width, std::uint32_t height, memory_options const & memory = {})
+		{
+			auto view = image_view<float>{.width = width, .height = height};
+
+			compressed_depth_buffer result
+			{
+				.tiles = image<depth_tile>::allocate(view.width_in_tiles(), view.height_in_tiles(), {.memory = memory}),
+				.pool = std::make_shared<depth_pixel_pool>(depth_pixel_pool{.memory = memory}),
+				.width = width,
+				.height = height,
+			};
+
+			for (std::uint32_t y = 0; y < result.tiles.height; ++y)
+				for (std::uint32_t x = 0; x < result.tiles.width; ++x)
+					result.tiles.at(x, y) = depth_tile{.planes = {{.c = 1.f}, {}}, .mask = 0, .mode = depth_tile_mode::one_plane, .pixels = nullptr};
+
+			return result;
+		}
+	};
+
+	struct depth_tile_counts
+	{
+		std::uint32_t one_plane = 0;
+		std::uint32_t two_planes = 0;
+		std::uint32_t full = 0;
+	};
+
+	// How many tiles are in each mode, to see how well a scene compresses
+	depth_tile_counts count_tile_modes(compressed_depth_view const & view);
+
+}
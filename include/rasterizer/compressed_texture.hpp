@@ -0,0 +1,140 @@
+#pragma once
+
+#include <rasterizer/texture.hpp>
+#include <rasterizer/color.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace rasterizer
+{
+
+	// 4x4 block of RGB texels with optional 1-bit alpha, 8 bytes (4 bits per texel)
+	// Layout matches BC1 / DXT1
+	struct bc1_block
+	{
+		std::uint16_t color0;
+		std::uint16_t color1;
+		std::uint32_t indices;
+	};
+
+	// 4x4 block of RGBA texels, 16 bytes (8 bits per texel)
+	// Layout matches BC3 / DXT5
+	struct bc3_block
+	{
+		std::uint8_t alpha0;
+		std::uint8_t alpha1;
+		std::uint8_t alpha_indices[6];
+		bc1_block color;
+	};
+
+	// Texels are read & written in row-major order, 16 per block
+
+	bc1_block encode_bc1(color4ub const * texels);
+	bc3_block encode_bc3(color4ub const * texels);
+
+	void decode(bc1_block const & block, color4ub * texels);
+	void decode(bc3_block const & block, color4ub * texels);
+
+	template <typename Block>
+	struct compressed_image
+	{
+		std::shared_ptr<Block[]> blocks;
+
+		// Size in texels, not in blocks
+		std::uint32_t width = 0;
+		std::uint32_t height = 0;
+
+		explicit operator bool() const
+		{
+			return blocks != nullptr;
+		}
+
+		std::uint32_t width_in_blocks() const
+		{
+			return (width + 3) / 4;
+		}
+
+		std::uint32_t height_in_blocks() const
+		{
+			return (height + 3) / 4;
+		}
+
+		Block const & block_at(std::uint32_t bx, std::uint32_t by) const
+		{
+			return blocks[bx + by * width_in_blocks()];
+		}
+
+		static compressed_image allocate(std::uint32_t width, std::uint32_t height)
+		{
+			std::uint32_t block_count = ((width + 3) / 4) * ((height + 3) / 4);
+
+			return compressed_image
+			{
+				.blocks = std::shared_ptr<Block[]>(new Block[block_count]),
+				.width = width,
+				.height = height,
+			};
+		}
+	};
+
+	template <typename Block>
+	struct compressed_texture
+	{
+		std::vector<compressed_image<Block>> mipmaps;
+
+		std::uint32_t width() const
+		{
+			if (!mipmaps.empty())
+				return mipmaps.front().width;
+			return 0;
+		}
+
+		std::uint32_t height() const
+		{
+			if (!mipmaps.empty())
+				return mipmaps.front().height;
+			return 0;
+		}
+	};
+
+	// Compresses every mipmap level of the texture, meant to be run when building assets
+	// BC1 drops alpha to 1 bit (4 bpp), BC3 keeps full alpha (8 bpp)
+
+	compressed_texture<bc1_block> compress_bc1(texture<color4ub> const & texture);
+	compressed_texture<bc3_block> compress_bc3(texture<color4ub> const & texture);
+
+	// Small direct-mapped cache of decoded blocks, so that sampling decodes only
+	// the blocks it actually touches and neighbouring texels reuse the result
+	// Not thread-safe: keep one per thread, and don't keep it around longer than
+	// the textures it was used with
+
+	template <typename Block>
+	struct decoded_block_cache
+	{
+		static constexpr std::uint32_t size_x = 8;
+		static constexpr std::uint32_t size_y = 4;
+
+		Block const * blocks[size_x * size_y] = {};
+		color4ub texels[size_x * size_y][16];
+
+		color4ub fetch(compressed_image<Block> const & image, std::uint32_t x, std::uint32_t y)
+		{
+			std::uint32_t bx = x / 4;
+			std::uint32_t by = y / 4;
+
+			auto const * block = &image.block_at(bx, by);
+			std::uint32_t slot = (bx % size_x) + (by % size_y) * size_x;
+
+			if (blocks[slot] != block)
+			{
+				decode(*block, texels[slot]);
+				blocks[slot] = block;
+			}
+
+			return texels[slot][(x % 4) + (y % 4) * 4];
+		}
+	};
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+
+namespace rasterizer
+{
+
+	// Instruction sets the renderer's hot loops are compiled for, oldest first; the best one
+	// the CPU supports is picked on first use, so one binary runs everywhere and still uses
+	// the wider vectors of newer CPUs
+	//   baseline - what the compiler targets, SSE2 on x86-64
+	//   avx2     - AVX2, FMA, BMI2 & F16C: Haswell, Zen and newer
+	//   avx512   - the above plus AVX-512 F, BW, DQ & VL: Skylake-SP, Ice Lake, Zen 4 and newer
+	enum class instruction_set
+	{
+		baseline,
+		avx2,
+		avx512,
+	};
+
+	inline constexpr std::size_t instruction_set_count = 3;
+
+	extern char const * const instruction_set_names[instruction_set_count];
+
+	// Best instruction set supported by both the CPU and the OS
+	instruction_set detect_instruction_set();
+
+	// Instruction set the renderer uses: the detected one, unless the RASTERIZER_ISA environment
+	// variable names another (baseline, avx2 or avx512), which is only honored if supported
+	// Chosen once, the first time it's needed
+	instruction_set active_instruction_set();
+
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <rasterizer/framebuffer.hpp>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace rasterizer
+{
+
+	// Depth formats: encode a normalized depth in [0, 1] for clears, encode_ndc the NDC z
+	// of a fragment for draws, load & store encoded values
+	// Tests compare encoded values, so they run at the format's own width
+
+	template <typename Depth>
+	struct depth_format;
+
+	template <>
+	struct depth_format<std::uint32_t>
+	{
+		using value_type = std::uint32_t;
+
+		static value_type encode(float depth)
+		{
+			// Converting out-of-range floats is undefined, saturate first
+			if (!(depth > 0.f))
+				return 0;
+			if (depth >= 1.f)
+				return std::uint32_t(-1);
+			return depth * 4294967296.f;
+		}
+
+		static value_type encode_ndc(float z) { return encode(0.5f + 0.5f * z); }
+
+		static value_type load(std::uint32_t const & pixel) { return pixel; }
+		static void store(std::uint32_t & pixel, value_type value) { pixel = value; }
+	};
+
+	template <>
+	struct depth_format<std::uint16_t>
+	{
+		using value_type = std::uint16_t;
+
+		static value_type encode(float depth)
+		{
+			return std::max(0.f, std::min(1.f, depth)) * 65535.f + 0.5f;
+		}
+
+		static value_type encode_ndc(float z) { return encode(0.5f + 0.5f * z); }
+
+		static value_type load(std::uint16_t const & pixel) { return pixel; }
+		static void store(std::uint16_t & pixel, value_type value) { pixel = value; }
+	};
+
+	template <>
+	struct depth_format<depth24>
+	{
+		using value_type = std::uint32_t;
+
+		static value_type encode(float depth)
+		{
+			// Rounding can reach 2^24 near the top of the range, clamp it back
+			return std::min(std::max(0.f, std::min(1.f, depth)) * 16777215.f + 0.5f, 16777215.f);
+		}
+
+		static value_type encode_ndc(float z) { return encode(0.5f + 0.5f * z); }
+
+		static value_type load(depth24 const & pixel)
+		{
+			return pixel.bytes[0] | (pixel.bytes[1] << 8) | (pixel.bytes[2] << 16);
+		}
+
+		static void store(depth24 & pixel, value_type value)
+		{
+			pixel.bytes[0] = value;
+			pixel.bytes[1] = value >> 8;
+			pixel.bytes[2] = value >> 16;
+		}
+	};
+
+	template <>
+	struct depth_format<float>
+	{
+		using value_type = float;
+
+		// Reversed: floats are densest near 0, which is where the far plane ends up
+		static value_type encode(float depth)
+		{
+			return 1.f - depth;
+		}
+
+		// Stored as it is: with matrix4x4f::perspective_reversed, z / w is already 1 at the near
+		// plane and 0 at the far one, and remapping it to [0, 1] first would round the far
+		// depths to the spacing of floats near 1, which is what this format avoids
+		static value_type encode_ndc(float z) { return z; }
+
+		static value_type load(float const & pixel) { return pixel; }
+		static void store(float & pixel, value_type value) { pixel = value; }
+	};
+
+}
@@ -5,16 +5,25 @@
 #include <rasterizer/mesh.hpp>
 #include <rasterizer/light.hpp>
 #include <rasterizer/texture.hpp>
+#include <rasterizer/compressed_texture.hpp>
 #include <rasterizer/sampler.hpp>
 
 #include <optional>
+#include <variant>
 
 namespace rasterizer
 {
 
+	using texture_pointer = std::variant
+	<
+		texture<color4ub> const *,
+		compressed_texture<bc1_block> const *,
+		compressed_texture<bc3_block> const *
+	>;
+
 	struct texture_and_sampler
 	{
-		struct texture<color4ub> const * texture;
+		texture_pointer texture;
 		struct sampler sampler;
 	};
 
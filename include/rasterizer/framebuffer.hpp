@@ -2,27 +2,60 @@
 
 #include <rasterizer/image_view.hpp>
 #include <rasterizer/color.hpp>
+#include <rasterizer/compressed_depth.hpp>
+#include <rasterizer/heatmap.hpp>
+
+#include <cstdint>
+#include <variant>
 
 namespace rasterizer
 {
 
+	// 24-bit unsigned normalized depth, packed into 3 little-endian bytes
+	struct depth24
+	{
+		std::uint8_t bytes[3];
+	};
+
+	// Supported depth buffer formats:
+	//   std::uint32_t - 32-bit unsigned normalized (D32)
+	//   std::uint16_t - 16-bit unsigned normalized (D16)
+	//   depth24       - 24-bit unsigned normalized, packed (D24)
+	//   float         - reversed-Z float: near is 1 and far is 0, draws store z / w as it
+	//                   is, so project with matrix4x4f::perspective_reversed; clears store
+	//                   1 - depth. Use greater tests instead of less tests with this format
+	//   compressed_depth_view
+	//                 - float depth, stored per tile as one or two plane equations
+	//                   when possible, see compressed_depth.hpp
+	using depth_view = std::variant
+	<
+		image_view<std::uint32_t>,
+		image_view<std::uint16_t>,
+		image_view<depth24>,
+		image_view<float>,
+		compressed_depth_view
+	>;
+
 	struct framebuffer
 	{
 		image_view<color4ub> color;
-		image_view<std::uint32_t> depth;
+		depth_view depth;
+
+		// Debug outputs, none by default
+		heatmap_views heatmaps = {};
 
 		std::uint32_t width() const
 		{
 			if (color)
 				return color.width;
-			return depth.width;
+			return std::visit([](auto const & depth){ return depth.width; }, depth);
 		}
 
 		std::uint32_t height() const
 		{
 			if (color)
 				return color.height;
-			return depth.height;
+			return std::visit([](auto const & depth){ return depth.height; }, depth);
 		}
 	};
 
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <rasterizer/image.hpp>
+#include <rasterizer/color.hpp>
+
+#include <cstdint>
+
+namespace rasterizer
+{
+
+	// Side buffers that draws accumulate into, to find where fill is wasted;
+	// each one is optional, and draws only pay for the bookkeeping when one is set
+	struct heatmap_views
+	{
+		// Per pixel, the same size as the framebuffer:
+		// times it was covered by a triangle & depth tested,
+		image_view<std::uint32_t> depth_tests;
+
+		// times it passed the depth test and was shaded,
+		image_view<std::uint32_t> shaded;
+
+		// and times its color or depth was written
+		image_view<std::uint32_t> writes;
+
+		// Per tile_size x tile_size screen tile: time spent rasterizing & shading its quads, in
+		// timestamp counter ticks where available (roughly cycles), nanoseconds otherwise
+		image_view<std::uint32_t> tile_cost;
+
+		explicit operator bool() const
+		{
+			return depth_tests || shaded || writes || tile_cost;
+		}
+	};
+
+	struct heatmap_buffers
+	{
+		image<std::uint32_t> depth_tests;
+		image<std::uint32_t> shaded;
+		image<std::uint32_t> writes;
+		image<std::uint32_t> tile_cost;
+
+		heatmap_views view() const
+		{
+			return heatmap_views
+			{
+				.depth_tests = depth_tests.view(),
+				.shaded = shaded.view(),
+				.writes = writes.view(),
+				.tile_cost = tile_cost.view(),
+			};
+		}
+
+		// All of the buffers, for a width x height framebuffer
+		static heatmap_buffers allocate(std::uint32_t width, std::uint32_t height);
+	};
+
+	// Zeroes every buffer that is set
+	void clear(heatmap_views const & heatmaps);
+
+	// Maps values to colors from black (0) through blue, cyan, green, yellow and red to white
+	// (max_value and above), with max_value = 0 standing for the largest value in the image
+	// The result may be larger than the values: a value per tile of the result, like tile_cost,
+	// colors that tile's pixels, other sizes are scaled up to the result's size
+	void false_color(image_view<std::uint32_t> const & values, image_view<color4ub> const & result, std::uint32_t max_value = 0);
+
+}
@@ -2,52 +2,115 @@
 
 #include <rasterizer/image_view.hpp>
 #include <rasterizer/color.hpp>
+#include <rasterizer/memory.hpp>
 
 #include <cstdint>
 #include <memory>
+#include <numeric>
+#include <type_traits>
 #include <filesystem>
+#include <span>
 
 namespace rasterizer
 {
 
+	// Rows (and tiles, for tiled images) start on cache line boundaries
+	constexpr std::size_t image_alignment = 64;
+
+	struct image_allocation
+	{
+		image_layout layout = image_layout::linear;
+
+		// Pads rows whose size is a multiple of 4 KiB with an extra cache line, so that
+		// vertically adjacent pixels don't compete for the same cache sets
+		bool pad_rows = false;
+
+		memory_options memory = {};
+	};
+
+	// Copies share the pixel storage, which may also be owned by something
+	// else than the image, e.g. a memory-mapped file
+
 	template <typename Pixel>
 	struct image
 	{
-		std::unique_ptr<Pixel[]> pixels;
+		std::shared_ptr<Pixel[]> pixels;
 		std::uint32_t width = 0;
 		std::uint32_t height = 0;
+		std::uint32_t pitch = 0;
+		image_layout layout = image_layout::linear;
 
 		explicit operator bool() const
 		{
 			return pixels != nullptr;
 		}
 
-		image_view<Pixel> view()
+		image_view<Pixel> view() const
 		{
 			return image_view<Pixel>
 			{
 				.pixels = pixels.get(),
 				.width = width,
 				.height = height,
+				.pitch = pitch,
+				.layout = layout,
 			};
 		}
 
 		Pixel & at(std::uint32_t x, std::uint32_t y) const
 		{
-			return pixels[x + y * width];
+			return view().at(x, y);
 		}
 
-		static image allocate(std::uint32_t width, std::uint32_t height)
+		static image allocate(std::uint32_t width, std::uint32_t height, image_allocation const & allocation = {})
 		{
+			static_assert(std::is_trivially_copyable_v<Pixel> && std::is_trivially_destructible_v<Pixel>);
+
+			// Smallest pitch step (in pixels) that keeps every row aligned
+			std::size_t pitch_step = image_alignment / std::gcd(image_alignment, sizeof(Pixel));
+
+			std::size_t pitch = image_view<Pixel>{.width = width, .layout = allocation.layout}.row_pitch();
+			pitch = (pitch + pitch_step - 1) / pitch_step * pitch_step;
+
+			if (allocation.pad_rows && (pitch * sizeof(Pixel)) % 4096 == 0)
+				pitch += pitch_step;
+
+			image_view<Pixel> view{.width = width, .height = height, .pitch = (std::uint32_t)pitch, .layout = allocation.layout};
+
+			auto storage = allocate_memory(view.storage_size() * sizeof(Pixel), image_alignment, allocation.memory);
+
 			return image
 			{
-				.pixels = std::unique_ptr<Pixel[]>(new Pixel[width * height]),
+				.pixels = std::shared_ptr<Pixel[]>(storage, (Pixel *)storage.get()),
 				.width = width,
 				.height = height,
+				.pitch = view.pitch,
+				.layout = allocation.layout,
 			};
 		}
 	};
 
+	// Copies pixels between images of the same size, converting between layouts
+	void copy(image_view<color4ub> const & source, image_view<color4ub> const & destination);
+
+	// Order of the channels of 32-bit pixels in memory
+	enum class channel_order
+	{
+		rgba,
+		bgra,
+	};
+
+	// Same as above, but writes the destination in the given channel order, e.g. for
+	// presenting to a window surface whose format isn't RGBA
+	void copy(image_view<color4ub> const & source, image_view<color4ub> const & destination, channel_order destination_order);
+
 	image<color4ub> load_image(std::filesystem::path const & path);
 
+	// Decodes an encoded file (JPEG, PNG, etc) that is already in memory
+	image<color4ub> load_image(std::span<std::uint8_t const> data);
+
+	// Writes an uncompressed TGA if the extension is .tga, a binary PPM (without alpha) otherwise
+	// Returns false if the file couldn't be written
+	bool save_image(std::filesystem::path const & path, image_view<color4ub> const & image);
+
 }
@@ -1,10 +1,23 @@
 #pragma once
 
 #include <cstdint>
+#include <cstddef>
 
 namespace rasterizer
 {
 
+	enum class image_layout
+	{
+		// Rows of pixels one after another
+		linear,
+
+		// Tiles of tile_size x tile_size pixels stored contiguously, tiles in row-major order
+		// Storage is padded to whole tiles
+		tiled,
+	};
+
+	constexpr std::uint32_t tile_size = 8;
+
 	template <typename Pixel>
 	struct image_view
 	{
@@ -12,15 +25,122 @@ namespace rasterizer
 		std::uint32_t width = 0;
 		std::uint32_t height = 0;
 
+		// Distance in pixels between the starts of consecutive rows (linear layout)
+		// or rows of tiles (tiled layout), 0 means tightly packed
+		std::uint32_t pitch = 0;
+
+		image_layout layout = image_layout::linear;
+
 		explicit operator bool() const
 		{
 			return pixels != nullptr;
 		}
 
+		std::uint32_t width_in_tiles() const
+		{
+			return (width + tile_size - 1) / tile_size;
+		}
+
+		std::uint32_t height_in_tiles() const
+		{
+			return (height + tile_size - 1) / tile_size;
+		}
+
+		std::size_t row_pitch() const
+		{
+			if (pitch != 0)
+				return pitch;
+			if (layout == image_layout::tiled)
+				return std::size_t(width_in_tiles()) * tile_size * tile_size;
+			return width;
+		}
+
+		// Number of pixels spanned in storage, including padding
+		std::size_t storage_size() const
+		{
+			if (layout == image_layout::tiled)
+				return row_pitch() * height_in_tiles();
+			return row_pitch() * height;
+		}
+
+		std::size_t offset(std::uint32_t x, std::uint32_t y) const
+		{
+			if (layout == image_layout::tiled)
+				return (y / tile_size) * row_pitch() + (x / tile_size) * (tile_size * tile_size) + (y % tile_size) * tile_size + (x % tile_size);
+			return x + y * row_pitch();
+		}
+
+		// Offset between vertically adjacent pixels, as long as they are in the same tile
+		std::size_t row_step() const
+		{
+			if (layout == image_layout::tiled)
+				return tile_size;
+			return row_pitch();
+		}
+
 		Pixel & at(std::uint32_t x, std::uint32_t y) const
 		{
-			return pixels[x + y * width];
+			return pixels[offset(x, y)];
+		}
+
+		// Shares the pixels, nothing is copied
+		// Tiled views can only be split at multiples of tile_size
+		image_view subview(std::uint32_t x, std::uint32_t y, std::uint32_t width, std::uint32_t height) const
+		{
+			return image_view
+			{
+				.pixels = &at(x, y),
+				.width = width,
+				.height = height,
+				.pitch = (std::uint32_t)row_pitch(),
+				.layout = layout,
+			};
 		}
 	};
 
+	// Calls f(Pixel * run, std::size_t count) for contiguous runs of pixels covering the view
+	// Only touches the pixels of the view, never the padding or pixels outside a subview
+	template <typename Pixel, typename F>
+	void for_each_run(image_view<Pixel> const & view, F && f)
+	{
+		if (view.layout == image_layout::linear)
+		{
+			if (view.row_pitch() == view.width)
+			{
+				f(view.pixels, std::size_t(view.width) * view.height);
+				return;
+			}
+
+			for (std::uint32_t y = 0; y < view.height; ++y)
+				f(&view.at(0, y), std::size_t(view.width));
+			return;
+		}
+
+		for (std::uint32_t ty = 0; ty < view.height; ty += tile_size)
+		{
+			for (std::uint32_t tx = 0; tx < view.width; tx += tile_size)
+			{
+				if (tx + tile_size <= view.width && ty + tile_size <= view.height)
+				{
+					f(&view.at(tx, ty), std::size_t(tile_size * tile_size));
+					continue;
+				}
+
+				std::uint32_t run = view.width - tx < tile_size ? view.width - tx : tile_size;
+				for (std::uint32_t y = ty; y < view.height && y < ty + tile_size; ++y)
+					f(&view.at(tx, y), std::size_t(run));
+			}
+		}
+	}
+
+	template <typename Pixel>
+	void fill(image_view<Pixel> const & view, Pixel const & value)
+	{
+		for_each_run(view, [&value](Pixel * run, std::size_t count)
+		{
+			for (Pixel * end = run + count; run != end; ++run)
+				*run = value;
+		});
+	}
+
 }
@@ -98,6 +98,23 @@ namespace rasterizer
 				0.f, 0.f, -1.f, 0.f,
 			};
 		}
+
+		// For reversed-Z float depth buffers: z / w is 1 at the near plane and falls to 0 at the
+		// far one, as near / distance does, so that distant depths keep their precision
+		// Nothing past the far plane is clipped, the depth test rejects it against a clear to far
+		static matrix4x4f perspective_reversed(float near, float far, float fovY, float aspect_ratio)
+		{
+			float top = near * std::tan(fovY / 2.f);
+			float right = top * aspect_ratio;
+
+			return matrix4x4f
+			{
+				near / right, 0.f, 0.f, 0.f,
+				0.f, near / top, 0.f, 0.f,
+				0.f, 0.f, near / (far - near), far * near / (far - near),
+				0.f, 0.f, -1.f, 0.f,
+			};
+		}
 	};
 
 	inline vector4f operator * (matrix4x4f const & m, vector4f const & v)
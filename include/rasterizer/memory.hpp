@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+namespace rasterizer
+{
+
+	constexpr std::size_t huge_page_size = 2 * 1024 * 1024;
+
+	struct memory_options
+	{
+		// Tries explicit huge pages first, then transparent huge pages, then falls back
+		// to normal pages; allocations smaller than half a huge page always use normal pages
+		bool huge_pages = false;
+
+		// Touches every page up front, so that the first use doesn't pay for page faults
+		bool prefault = false;
+	};
+
+	// Returned memory is aligned to at least `alignment` bytes (at most a normal page)
+	std::shared_ptr<void> allocate_memory(std::size_t size, std::size_t alignment, memory_options const & options = {});
+
+}
@@ -13,9 +13,9 @@ namespace rasterizer
 		static constexpr vector2f default_texcoord {0.5f, 0.5f};
 
 		attribute<vector3f> positions = {};
-		attribute<vector3f> normals = {&default_normal, 1};
-		attribute<vector4f> colors = {&default_color, 1};
-		attribute<vector2f> texcoords = {&default_texcoord, 1};
+		attribute<vector3f> normals = {&default_normal, 0};
+		attribute<vector4f> colors = {&default_color, 0};
+		attribute<vector2f> texcoords = {&default_texcoord, 0};
 		std::uint32_t const * indices = nullptr;
 		std::uint32_t count = 0;
 	};
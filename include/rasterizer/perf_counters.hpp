@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rasterizer
+{
+
+	// Hardware performance counters, read with perf_event_open on Linux
+
+	enum class perf_counter : std::uint8_t
+	{
+		cycles,
+		instructions,
+		llc_misses,
+		branch_misses,
+		dtlb_misses,
+	};
+
+	inline constexpr std::size_t perf_counter_count = 5;
+
+	inline constexpr char const * perf_counter_names[perf_counter_count] =
+	{
+		"cycles",
+		"instructions",
+		"llc_misses",
+		"branch_misses",
+		"dtlb_misses",
+	};
+
+	// Counts of the calling thread in user space, or differences between two reads
+	struct perf_values
+	{
+		std::uint64_t values[perf_counter_count] = {};
+
+		// Bit i is set when counter i could be read, CPUs and virtual machines
+		// don't all provide every counter
+		std::uint32_t available = 0;
+
+		bool has(perf_counter counter) const
+		{
+			return (available >> std::size_t(counter)) & 1;
+		}
+
+		std::uint64_t operator[] (perf_counter counter) const
+		{
+			return values[std::size_t(counter)];
+		}
+
+		// Sums only keep the counters available on both sides, except that
+		// anything can be added to an empty value
+		perf_values & operator += (perf_values const & other)
+		{
+			for (std::size_t i = 0; i < perf_counter_count; ++i)
+				values[i] += other.values[i];
+			available = (available == 0) ? other.available : (available & other.available);
+			return *this;
+		}
+
+		friend perf_values operator - (perf_values const & end, perf_values const & begin)
+		{
+			perf_values result;
+			for (std::size_t i = 0; i < perf_counter_count; ++i)
+				result.values[i] = end.values[i] - begin.values[i];
+			result.available = end.available & begin.available;
+			return result;
+		}
+	};
+
+	// Counting is off until enabled; each thread then opens its own counters the first time
+	// it reads them. Enabling returns false, and leaves counting off, if none of the counters
+	// can be opened (not Linux, no PMU, perf_event_paranoid too strict...)
+	bool enable_perf_counters(bool enable = true);
+
+	// A relaxed atomic load, cheap enough to check once per draw
+	bool perf_counters_enabled();
+
+	// Nothing is available while counting is off
+	perf_values read_perf_counters();
+
+}
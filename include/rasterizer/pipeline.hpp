@@ -0,0 +1,144 @@
+#pragma once
+
+#include <rasterizer/vector.hpp>
+#include <rasterizer/light.hpp>
+#include <rasterizer/sampler.hpp>
+#include <rasterizer/texture.hpp>
+#include <rasterizer/compressed_texture.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+// Stages of draw(), exposed so that they can be benchmarked and tested on their own
+
+namespace rasterizer
+{
+
+	// Vertex after the vertex stage, position is in clip space
+	struct vertex
+	{
+		vector4f position;
+		vector3f world_position;
+		vector3f normal;
+		vector4f color;
+		vector2f texcoord;
+	};
+
+	// Clips triangles in [begin, end) against the near & far planes, in place
+	// There must be room for 12 vertices at begin, returns the new end
+	vertex * clip_triangle(vertex * begin, vertex * end);
+
+	// Ambient and diffuse lighting at a point, to be multiplied with its albedo
+	inline vector3f compute_lighting(light_settings const & lights, vector3f const & position, vector3f const & normal)
+	{
+		vector3f lighting = lights.ambient_light;
+
+		for (auto const & light : lights.directional_lights)
+		{
+			lighting = lighting + std::max(0.f, dot(light.direction, normal)) * light.intensity;
+		}
+
+		for (auto const & light : lights.point_lights)
+		{
+			vector3f delta = light.position - position;
+			float distance = length(delta);
+			vector3f direction = delta / distance;
+			float attenuation = 1.f / (light.attenuation.x + light.attenuation.y * distance + light.attenuation.z * distance * distance);
+
+			lighting = lighting + std::max(0.f, dot(direction, normal)) * attenuation * light.intensity;
+		}
+
+		return lighting;
+	}
+
+	// Reads texels of one mipmap level, specialised per texture type
+
+	template <typename Texture>
+	struct texel_fetcher;
+
+	template <>
+	struct texel_fetcher<texture<color4ub>>
+	{
+		color4ub operator()(image<color4ub> const & mipmap, std::uint32_t x, std::uint32_t y)
+		{
+			return mipmap.at(x, y);
+		}
+	};
+
+	template <typename Block>
+	struct texel_fetcher<compressed_texture<Block>>
+	{
+		decoded_block_cache<Block> cache;
+
+		color4ub operator()(compressed_image<Block> const & mipmap, std::uint32_t x, std::uint32_t y)
+		{
+			return cache.fetch(mipmap, x, y);
+		}
+	};
+
+	// Filtered sample for pixel (dx, dy) of a 2x2 quad, the texture coordinates
+	// of the whole quad select the mipmap level
+	template <typename Texture>
+	vector4f sample(Texture const & texture, sampler const & sampler, texel_fetcher<Texture> & fetch, vector2f const (&texcoord)[2][2], int dx, int dy)
+	{
+		vector2f texture_scale { (float)texture.width(), (float)texture.height() };
+
+		vector2f tc = texture_scale * texcoord[dy][dx];
+		vector2f tc_dx = texture_scale * (texcoord[dy][1] - texcoord[dy][0]);
+		vector2f tc_dy = texture_scale * (texcoord[1][dx] - texcoord[0][dx]);
+
+		float texel_area = 1.f / std::abs(det2D(tc_dx, tc_dy));
+		bool magnification = texel_area >= 1.f;
+
+		auto const * mipmap = &texture.mipmaps[0];
+		filtering filter;
+
+		if (magnification)
+		{
+			filter = sampler.mag_filter;
+		}
+		else
+		{
+			int mipmap_level = std::ceil(-std::log2(std::min(1.f, texel_area)) / 2.f);
+
+			mipmap = &texture.mipmaps[std::min<int>(mipmap_level, texture.mipmaps.size() - 1)];
+			filter = sampler.min_filter;
+		}
+
+		tc.x = mipmap->width * std::fmod(texcoord[dy][dx].x, 1.f);
+		tc.y = mipmap->height * std::fmod(texcoord[dy][dx].y, 1.f);
+
+		if (filter == filtering::nearest || mipmap->width == 1 || mipmap->height == 1)
+		{
+			int ix = std::floor(tc.x);
+			int iy = std::floor(tc.y);
+
+			return to_vector4f(fetch(*mipmap, ix, iy));
+		}
+
+		tc.x -= 0.5f;
+		tc.y -= 0.5f;
+
+		tc.x = std::max(0.f, std::min(mipmap->width - 1.f, tc.x));
+		tc.y = std::max(0.f, std::min(mipmap->height - 1.f, tc.y));
+
+		int ix = std::min<int>(mipmap->width - 2, std::floor(tc.x));
+		int iy = std::min<int>(mipmap->height - 2, std::floor(tc.y));
+
+		tc.x -= ix;
+		tc.y -= iy;
+
+		// The inline conversion, the bulk one is compiled out of line for the baseline instruction
+		// set and would be a call out of the draw kernels for 4 texels
+		vector4f samples[4]
+		{
+			to_vector4f(fetch(*mipmap, ix + 0, iy + 0)),
+			to_vector4f(fetch(*mipmap, ix + 1, iy + 0)),
+			to_vector4f(fetch(*mipmap, ix + 0, iy + 1)),
+			to_vector4f(fetch(*mipmap, ix + 1, iy + 1)),
+		};
+
+		return (1.f - tc.y) * ((1.f - tc.x) * samples[0] + tc.x * samples[1]) + tc.y * ((1.f - tc.x) * samples[2] + tc.x * samples[3]);
+	}
+
+}
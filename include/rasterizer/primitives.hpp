@@ -0,0 +1,44 @@
+#pragma once
+
+#include <rasterizer/mesh.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace rasterizer
+{
+
+	// Vertex data of a generated mesh; view() points into it, so it must outlive the view
+	struct mesh_data
+	{
+		std::vector<vector3f> positions;
+		std::vector<vector3f> normals;
+		std::vector<vector2f> texcoords;
+		std::vector<std::uint32_t> indices;
+
+		mesh view() const;
+	};
+
+	// The same vertices in compressed attribute formats: half float positions & texcoords and
+	// octahedral normals, 14 bytes per vertex instead of 32
+	struct packed_mesh_data
+	{
+		std::vector<std::uint16_t> positions;
+		std::vector<std::int16_t> normals;
+		std::vector<std::uint16_t> texcoords;
+		std::vector<std::uint32_t> indices;
+
+		mesh view() const;
+	};
+
+	// Positions have to stay within half float range and precision, like the unit-sized meshes below
+	packed_mesh_data pack(mesh_data const & data);
+
+	// Sphere of radius 1 centered at the origin, with rings x segments quads
+	// and texcoords wrapping around it once
+	mesh_data make_sphere(std::uint32_t rings, std::uint32_t segments);
+
+	// Square from (-1, -1) to (1, 1) in the XY plane, facing +Z, split into cells x cells quads
+	mesh_data make_plane(std::uint32_t cells);
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <rasterizer/perf_counters.hpp>
+
+#include <cstdint>
+
+namespace rasterizer
+{
+
+	// Pipeline statistics, counted by draw() when asked to; counters only ever
+	// grow, so the same stats can accumulate a single draw or a whole frame
+	struct render_stats
+	{
+		std::uint64_t draws = 0;
+
+		// Triangles read from the mesh
+		std::uint64_t triangles = 0;
+
+		// Triangles crossing the near or far plane, which were split, and those
+		// entirely beyond one of them, which were dropped
+		std::uint64_t clipped_triangles = 0;
+		std::uint64_t clip_rejected_triangles = 0;
+
+		// Triangles left after clipping that were dropped by cull_mode or for having no area
+		std::uint64_t culled_triangles = 0;
+		std::uint64_t zero_area_triangles = 0;
+
+		// Triangles left after clipping & culling
+		std::uint64_t rasterized_triangles = 0;
+
+		// 2x2 pixel quads visited while rasterizing
+		std::uint64_t quads = 0;
+
+		// Pixels inside a triangle, all of which go through the depth test; then
+		// those that passed it, and those that were shaded & written
+		std::uint64_t covered_pixels = 0;
+		std::uint64_t depth_passed_pixels = 0;
+		std::uint64_t shaded_pixels = 0;
+
+		// Hardware counters over the draws, when enable_perf_counters() succeeded
+		perf_values perf = {};
+
+		// Fraction of the visited quads' pixels that were inside a triangle
+		double quad_efficiency() const
+		{
+			return quads == 0 ? 0.0 : covered_pixels / (4.0 * quads);
+		}
+
+		render_stats & operator += (render_stats const & other)
+		{
+			draws += other.draws;
+			triangles += other.triangles;
+			clipped_triangles += other.clipped_triangles;
+			clip_rejected_triangles += other.clip_rejected_triangles;
+			culled_triangles += other.culled_triangles;
+			zero_area_triangles += other.zero_area_triangles;
+			rasterized_triangles += other.rasterized_triangles;
+			quads += other.quads;
+			covered_pixels += other.covered_pixels;
+			depth_passed_pixels += other.depth_passed_pixels;
+			shaded_pixels += other.shaded_pixels;
+			perf += other.perf;
+			return *this;
+		}
+	};
+
+}
@@ -4,13 +4,26 @@
 #include <rasterizer/viewport.hpp>
 #include <rasterizer/framebuffer.hpp>
 #include <rasterizer/draw_command.hpp>
+#include <rasterizer/render_stats.hpp>
 
 namespace rasterizer
 {
 
 	void clear(image_view<color4ub> const & color_buffer, vector4f const & color);
+
+	// Store value as is, in the buffer's encoding
 	void clear(image_view<std::uint32_t> const & depth_buffer, std::uint32_t value);
+	void clear(image_view<std::uint16_t> const & depth_buffer, std::uint16_t value);
+	void clear(image_view<depth24> const & depth_buffer, std::uint32_t value);
+	void clear(image_view<float> const & depth_buffer, float value);
+
+	// Only resets the tiles, the per-pixel storage isn't touched
+	void clear(compressed_depth_view const & depth_buffer, float depth);
+
+	// Clears to a normalized depth in [0, 1] (1 is the far plane), encoded for the buffer's format
+	void clear(depth_view const & depth_buffer, float depth);
 
-	void draw(framebuffer const & framebuffer, viewport const & viewport, draw_command const & command);
+	// When stats isn't null, the draw's pipeline statistics are added to it
+	void draw(framebuffer const & framebuffer, viewport const & viewport, draw_command const & command, render_stats * stats = nullptr);
 
 }
@@ -0,0 +1,707 @@
+#pragma once
+
+#include <rasterizer/pipeline.hpp>
+#include <rasterizer/framebuffer.hpp>
+#include <rasterizer/viewport.hpp>
+#include <rasterizer/settings.hpp>
+#include <rasterizer/render_stats.hpp>
+#include <rasterizer/depth_format.hpp>
+#include <rasterizer/trace.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Programmable shading: draw() with a vertex and a fragment shader of your own, given as
+// function objects (lambdas work) that get inlined into the rasterizer, along with the
+// interpolation of exactly the varyings they pass each other. The built-in draw_command
+// goes through the same rasterize(), with shaders doing its fixed-function shading
+//
+// Shader draws are compiled where they're called, for the instruction set that code is
+// compiled for: the built-in draw's runtime choice (see cpu_features.hpp) doesn't apply,
+// and capture:: doesn't record them
+
+namespace rasterizer
+{
+
+	// Varyings are what the vertex shader passes to the fragment shader: a trivially copyable
+	// struct made of floats only (vector2f, vector3f & vector4f members are fine), or an empty
+	// one. They're interpolated float by float
+
+	// l0 * v0 + l1 * v1 (+ l2 * v2)
+	template <typename Varyings>
+	Varyings interpolate(float l0, Varyings const & v0, float l1, Varyings const & v1)
+	{
+		static_assert(std::is_trivially_copyable_v<Varyings> && (std::is_empty_v<Varyings> || sizeof(Varyings) % sizeof(float) == 0));
+
+		if constexpr (std::is_empty_v<Varyings>)
+			return {};
+		else
+		{
+			using floats = std::array<float, sizeof(Varyings) / sizeof(float)>;
+
+			auto const f0 = std::bit_cast<floats>(v0);
+			auto const f1 = std::bit_cast<floats>(v1);
+
+			floats result;
+			[&]<std::size_t ... I>(std::index_sequence<I...>)
+			{
+				((result[I] = l0 * f0[I] + l1 * f1[I]), ...);
+			}(std::make_index_sequence<result.size()>{});
+
+			return std::bit_cast<Varyings>(result);
+		}
+	}
+
+	template <typename Varyings>
+	Varyings interpolate(float l0, Varyings const & v0, float l1, Varyings const & v1, float l2, Varyings const & v2)
+	{
+		static_assert(std::is_trivially_copyable_v<Varyings> && (std::is_empty_v<Varyings> || sizeof(Varyings) % sizeof(float) == 0));
+
+		if constexpr (std::is_empty_v<Varyings>)
+			return {};
+		else
+		{
+			using floats = std::array<float, sizeof(Varyings) / sizeof(float)>;
+
+			auto const f0 = std::bit_cast<floats>(v0);
+			auto const f1 = std::bit_cast<floats>(v1);
+			auto const f2 = std::bit_cast<floats>(v2);
+
+			floats result;
+			[&]<std::size_t ... I>(std::index_sequence<I...>)
+			{
+				((result[I] = l0 * f0[I] + l1 * f1[I] + l2 * f2[I]), ...);
+			}(std::make_index_sequence<result.size()>{});
+
+			return std::bit_cast<Varyings>(result);
+		}
+	}
+
+	// What the vertex shader returns, position is in clip space
+	template <typename Varyings>
+	struct shaded_vertex
+	{
+		vector4f position;
+		[[no_unique_address]] Varyings varyings;
+	};
+
+	// A pixel the fragment shader colors, one of a 2x2 quad
+	// Varyings are interpolated when asked for, perspective-correct, so that those a shader
+	// only reads on some paths cost nothing on the others
+	template <typename Varyings>
+	struct fragment
+	{
+		// Window coordinates of the pixel, and its place in the quad
+		std::int32_t x, y;
+		int dx, dy;
+
+		// Varyings of the triangle's vertices, and their weights at each pixel of the quad,
+		// indexed [vertex][dy][dx]
+		Varyings const * vertices[3];
+		float const (*weights)[2][2];
+
+		// One of the varyings at the pixel's center
+		template <typename T>
+		T varying(T Varyings::* member) const
+		{
+			return weights[0][dy][dx] * (vertices[0]->*member) + weights[1][dy][dx] * (vertices[1]->*member) + weights[2][dy][dx] * (vertices[2]->*member);
+		}
+
+		// All of them
+		Varyings varyings() const
+		{
+			return interpolate(weights[0][dy][dx], *vertices[0], weights[1][dy][dx], *vertices[1], weights[2][dy][dx], *vertices[2]);
+		}
+
+		// One of the varyings at all 4 pixels of the quad, indexed [dy][dx], to take derivatives
+		// as sample() does; like a GPU's helper pixels, pixels outside of the triangle get values
+		// extrapolated from it
+		template <typename T>
+		void quad(T Varyings::* member, T (&values)[2][2]) const
+		{
+			for (int qy = 0; qy < 2; ++qy)
+				for (int qx = 0; qx < 2; ++qx)
+					values[qy][qx] = weights[0][qy][qx] * (vertices[0]->*member) + weights[1][qy][qx] * (vertices[1]->*member) + weights[2][qy][qx] * (vertices[2]->*member);
+		}
+	};
+
+	// vertex_shader(index) returns the shaded_vertex of a vertex, index being the vertex's
+	// number, or read from indices when they're set; fragment_shader(fragment) returns the
+	// color of a pixel that passed the depth test, in [0, 1]
+	// Both are called through const references, shaders keeping state across calls (caches)
+	// need mutable members
+	template <typename VertexShader, typename FragmentShader>
+	struct shader_command
+	{
+		VertexShader vertex_shader;
+		FragmentShader fragment_shader;
+
+		std::uint32_t const * indices = nullptr;
+		std::uint32_t count = 0;
+
+		enum cull_mode cull_mode = cull_mode::none;
+		depth_settings depth = {};
+	};
+
+	template <typename VertexShader>
+	using vertex_shader_varyings = decltype(std::declval<VertexShader const &>()(std::uint32_t{}).varyings);
+
+	// Stages of rasterize(), used by the built-in draw as well
+
+	// Point where the edge from v0 to v1 crosses a clipping plane, given their signed
+	// distances to the plane; the vertex is interpolated whole, position included
+	template <typename Vertex>
+	Vertex clip_intersect_edge(Vertex const & v0, Vertex const & v1, float value0, float value1)
+	{
+		// f(t) = at+b
+		// f(0) = v0 = b
+		// f(1) = v1 = a+v0 => a = v1 - v0
+		// f(t) = v0 + (v1 - v0) * t
+		// f(t) = 0 => t = -v0 / (v1 - v0) = v0 / (v0 - v1)
+
+		float t = value0 / (value0 - value1);
+
+		return interpolate(1.f - t, v0, t, v1);
+	}
+
+	// Clips a triangle against the plane dot(position, equation) = 0, writing the 0 to 2
+	// triangles left to result, returns their end
+	template <typename Vertex>
+	Vertex * clip_triangle(Vertex const * triangle, vector4f equation, Vertex * result)
+	{
+		float values[3] =
+		{
+			dot(triangle[0].position, equation),
+			dot(triangle[1].position, equation),
+			dot(triangle[2].position, equation),
+		};
+
+		std::uint8_t mask = (values[0] < 0.f ? 1 : 0) | (values[1] < 0.f ? 2 : 0) | (values[2] < 0.f ? 4 : 0);
+
+		switch (mask)
+		{
+		case 0b000:
+			// All vertices are inside allowed half-space
+			// No clipping required, copy the triangle to output
+			*result++ = triangle[0];
+			*result++ = triangle[1];
+			*result++ = triangle[2];
+			break;
+		case 0b001:
+			// Vertex 0 is outside allowed half-space
+			// Replace it with points on edges 01 and 02
+			// And re-triangulate
+			{
+				auto v01 = clip_intersect_edge(triangle[0], triangle[1], values[0], values[1]);
+				auto v02 = clip_intersect_edge(triangle[0], triangle[2], values[0], values[2]);
+				*result++ = v01;
+				*result++ = triangle[1];
+				*result++ = triangle[2];
+				*result++ = v01;
+				*result++ = triangle[2];
+				*result++ = v02;
+			}
+			break;
+		case 0b010:
+			// Vertex 1 is outside allowed half-space
+			// Replace it with points on edges 10 and 12
+			// And re-triangulate
+			{
+				auto v10 = clip_intersect_edge(triangle[1], triangle[0], values[1], values[0]);
+				auto v12 = clip_intersect_edge(triangle[1], triangle[2], values[1], values[2]);
+				*result++ = triangle[0];
+				*result++ = v10;
+				*result++ = triangle[2];
+				*result++ = triangle[2];
+				*result++ = v10;
+				*result++ = v12;
+			}
+			break;
+		case 0b011:
+			// Vertices 0 and 1 are outside allowed half-space
+			// Replace them with points on edges 02 and 12
+			*result++ = clip_intersect_edge(triangle[0], triangle[2], values[0], values[2]);
+			*result++ = clip_intersect_edge(triangle[1], triangle[2], values[1], values[2]);
+			*result++ = triangle[2];
+			break;
+		case 0b100:
+			// Vertex 2 is outside allowed half-space
+			// Replace it with points on edges 20 and 21
+			// And re-triangulate
+			{
+				auto v20 = clip_intersect_edge(triangle[2], triangle[0], values[2], values[0]);
+				auto v21 = clip_intersect_edge(triangle[2], triangle[1], values[2], values[1]);
+				*result++ = triangle[0];
+				*result++ = triangle[1];
+				*result++ = v20;
+				*result++ = v20;
+				*result++ = triangle[1];
+				*result++ = v21;
+			}
+			break;
+		case 0b101:
+			// Vertices 0 and 2 are outside allowed half-space
+			// Replace them with points on edges 01 and 21
+			*result++ = clip_intersect_edge(triangle[0], triangle[1], values[0], values[1]);
+			*result++ = triangle[1];
+			*result++ = clip_intersect_edge(triangle[2], triangle[1], values[2], values[1]);
+			break;
+		case 0b110:
+			// Vertices 1 and 2 are outside allowed half-space
+			// Replace them with points on edges 10 and 20
+			*result++ = triangle[0];
+			*result++ = clip_intersect_edge(triangle[1], triangle[0], values[1], values[0]);
+			*result++ = clip_intersect_edge(triangle[2], triangle[0], values[2], values[0]);
+			break;
+		case 0b111:
+			// All vertices are outside allowed half-space
+			// Clip the whole triangle, result is empty
+			break;
+		}
+
+		return result;
+	}
+
+	// clip_triangle() for any vertex type with a clip space position
+	template <typename Vertex>
+	Vertex * clip_near_far(Vertex * begin, Vertex * end)
+	{
+		static vector4f const equations[2] =
+		{
+			{0.f, 0.f,  1.f, 1.f}, // Z > -W  =>   Z + W > 0
+			{0.f, 0.f, -1.f, 1.f}, // Z <  W  => - Z + W > 0
+		};
+
+		Vertex result[12];
+
+		for (auto equation : equations)
+		{
+			auto result_end = result;
+
+			for (Vertex * triangle = begin; triangle != end; triangle += 3)
+				result_end = clip_triangle(triangle, equation, result_end);
+
+			end = std::copy(result, result_end, begin);
+		}
+
+		return end;
+	}
+
+	// Timestamp counter where there is one, cheap enough to time every quad
+	inline std::uint64_t heatmap_ticks()
+	{
+#if defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+
+	template <typename Value>
+	bool depth_test_passed(depth_test_mode mode, Value value, Value reference)
+	{
+		switch (mode)
+		{
+		case depth_test_mode::always: return true;
+		case depth_test_mode::never: return false;
+		case depth_test_mode::less: return value < reference;
+		case depth_test_mode::less_equal: return value <= reference;
+		case depth_test_mode::greater: return value > reference;
+		case depth_test_mode::greater_equal: return value >= reference;
+		case depth_test_mode::equal: return value == reference;
+		case depth_test_mode::not_equal: return value != reference;
+		}
+
+		// Unreachable
+		return true;
+	}
+
+	// Depth testing & writing for one kind of depth buffer
+	// set_triangle gets the triangle's vertices in window coordinates, set_quad
+	// the first pixel of the 2x2 quad whose pixels are then tested
+
+	template <typename DepthView>
+	struct depth_target;
+
+	template <typename Depth>
+	struct depth_target<image_view<Depth>>
+	{
+		using format = depth_format<Depth>;
+
+		image_view<Depth> buffer;
+		std::size_t row_step = buffer.row_step();
+		Depth * quad = nullptr;
+
+		void set_triangle(vector4f const &, vector4f const &, vector4f const &)
+		{}
+
+		void set_quad(std::int32_t x, std::int32_t y)
+		{
+			quad = buffer.pixels + buffer.offset(x, y);
+		}
+
+		// Returns false if the pixel is rejected
+		bool test(depth_settings const & settings, int dx, int dy, float ndc_z)
+		{
+			auto const depth = format::encode_ndc(ndc_z);
+			auto & pixel = quad[dx + dy * row_step];
+
+			if (!depth_test_passed(settings.mode, depth, format::load(pixel)))
+				return false;
+
+			if (settings.write)
+				format::store(pixel, depth);
+
+			return true;
+		}
+	};
+
+	// Depth comes from the triangle's plane rather than from the interpolated
+	// position, so that writes can store the plane itself
+
+	template <>
+	struct depth_target<compressed_depth_view>
+	{
+		compressed_depth_view buffer;
+		depth_plane plane = {};
+		depth_tile * tile = nullptr;
+		std::int32_t quad_x = 0;
+		std::int32_t quad_y = 0;
+
+		void set_triangle(vector4f const & p0, vector4f const & p1, vector4f const & p2)
+		{
+			float const d0 = 0.5f + 0.5f * p0.z;
+			float const d1 = 0.5f + 0.5f * p1.z;
+			float const d2 = 0.5f + 0.5f * p2.z;
+
+			vector2f const e1 {p1.x - p0.x, p1.y - p0.y};
+			vector2f const e2 {p2.x - p0.x, p2.y - p0.y};
+
+			float const det = e1.x * e2.y - e1.y * e2.x;
+
+			if (det == 0.f)
+			{
+				plane = {.c = d0};
+				return;
+			}
+
+			plane.a = ((d1 - d0) * e2.y - (d2 - d0) * e1.y) / det;
+			plane.b = ((d2 - d0) * e1.x - (d1 - d0) * e2.x) / det;
+			plane.c = d0 - plane.a * p0.x - plane.b * p0.y;
+		}
+
+		// Quads never straddle tiles
+		void set_quad(std::int32_t x, std::int32_t y)
+		{
+			tile = &buffer.tile_at(x, y);
+			quad_x = x;
+			quad_y = y;
+		}
+
+		bool test(depth_settings const & settings, int dx, int dy, float)
+		{
+			std::uint32_t const x = quad_x + dx;
+			std::uint32_t const y = quad_y + dy;
+
+			float const depth = evaluate(plane, x, y);
+
+			if (!depth_test_passed(settings.mode, depth, buffer.load(*tile, x, y)))
+				return false;
+
+			if (settings.write)
+				buffer.store(*tile, x, y, plane);
+
+			return true;
+		}
+	};
+
+	// Everything draw() does past picking the depth format: depth_buffer is the framebuffer's
+	// depth buffer, resolved to its type. Stats & heatmaps are only counted when Instrumented,
+	// so that draws without them don't pay for them
+	template <bool Instrumented, typename DepthView, typename VertexShader, typename FragmentShader>
+	void rasterize(framebuffer const & framebuffer, DepthView const & depth_buffer, viewport const & viewport, shader_command<VertexShader, FragmentShader> const & command, render_stats * stats)
+	{
+		using varyings_type = vertex_shader_varyings<VertexShader>;
+		using vertex_type = shaded_vertex<varyings_type>;
+
+		static_assert(std::is_same_v<std::invoke_result_t<FragmentShader const &, fragment<varyings_type> const &>, vector4f>,
+			"fragment shaders take the fragment of the vertex shader's varyings and return a vector4f");
+
+		depth_target<DepthView> depth{.buffer = depth_buffer};
+
+		render_stats counters;
+		auto const & heatmaps = framebuffer.heatmaps;
+
+		for (std::uint32_t vertex_index = 0; vertex_index + 2 < command.count; vertex_index += 3)
+		{
+			std::uint32_t indices[3]
+			{
+				vertex_index + 0,
+				vertex_index + 1,
+				vertex_index + 2,
+			};
+
+			if (command.indices)
+				for (int i = 0; i < 3; ++i)
+					indices[i] = command.indices[indices[i]];
+
+			vertex_type clipped_vertices[12];
+
+			for (int i = 0; i < 3; ++i)
+				clipped_vertices[i] = command.vertex_shader(indices[i]);
+
+			if constexpr (Instrumented)
+			{
+				++counters.triangles;
+
+				for (int i = 0; i < 3; ++i)
+				{
+					if (std::abs(clipped_vertices[i].position.z) > clipped_vertices[i].position.w)
+					{
+						++counters.clipped_triangles;
+						break;
+					}
+				}
+			}
+
+			auto clipped_vertices_end = clip_near_far(clipped_vertices, clipped_vertices + 3);
+
+			if constexpr (Instrumented)
+			{
+				if (clipped_vertices_end == clipped_vertices)
+				{
+					--counters.clipped_triangles;
+					++counters.clip_rejected_triangles;
+				}
+			}
+
+			for (auto triangle_begin = clipped_vertices; triangle_begin != clipped_vertices_end; triangle_begin += 3)
+			{
+				auto v0 = triangle_begin[0];
+				auto v1 = triangle_begin[1];
+				auto v2 = triangle_begin[2];
+
+				v0.position = perspective_divide(v0.position);
+				v1.position = perspective_divide(v1.position);
+				v2.position = perspective_divide(v2.position);
+
+				v0.position = apply(viewport, v0.position);
+				v1.position = apply(viewport, v1.position);
+				v2.position = apply(viewport, v2.position);
+
+				if (depth_buffer)
+					depth.set_triangle(v0.position, v1.position, v2.position);
+
+				float det012 = det2D(v1.position - v0.position, v2.position - v0.position);
+
+				// Barycentrics divide by the area, degenerate triangles cover nothing
+				if (det012 == 0.f)
+				{
+					if constexpr (Instrumented)
+						++counters.zero_area_triangles;
+					continue;
+				}
+
+				bool const ccw = det012 < 0.f;
+
+				bool culled = false;
+
+				switch (command.cull_mode)
+				{
+				case cull_mode::none:
+					if (ccw)
+					{
+						std::swap(v1, v2);
+						det012 = -det012;
+					}
+					break;
+				case cull_mode::cw:
+					culled = !ccw;
+					std::swap(v1, v2);
+					det012 = -det012;
+					break;
+				case cull_mode::ccw:
+					culled = ccw;
+					break;
+				}
+
+				if (culled)
+				{
+					if constexpr (Instrumented)
+						++counters.culled_triangles;
+					continue;
+				}
+
+				if constexpr (Instrumented)
+					++counters.rasterized_triangles;
+
+				std::int32_t xmin = std::max<std::int32_t>(viewport.xmin, 0);
+				std::int32_t xmax = std::min<std::int32_t>(viewport.xmax, framebuffer.width()) - 1;
+				std::int32_t ymin = std::max<std::int32_t>(viewport.ymin, 0);
+				std::int32_t ymax = std::min<std::int32_t>(viewport.ymax, framebuffer.height()) - 1;
+
+				xmin = std::max<float>(xmin, std::min({std::floor(v0.position.x), std::floor(v1.position.x), std::floor(v2.position.x)}));
+				xmax = std::min<float>(xmax, std::max({std::floor(v0.position.x), std::floor(v1.position.x), std::floor(v2.position.x)}));
+				ymin = std::max<float>(ymin, std::min({std::floor(v0.position.y), std::floor(v1.position.y), std::floor(v2.position.y)}));
+				ymax = std::min<float>(ymax, std::max({std::floor(v0.position.y), std::floor(v1.position.y), std::floor(v2.position.y)}));
+
+				// Quads start at even coordinates, so that they never straddle tiles of tiled
+				// framebuffers and pixels are addressed relative to the quad's first one
+
+				auto const color_row_step = framebuffer.color.row_step();
+
+				for (std::int32_t y = ymin & ~1; y <= ymax; y += 2)
+				{
+					for (std::int32_t x = xmin & ~1; x <= xmax; x += 2)
+					{
+						auto const color_quad = framebuffer.color ? framebuffer.color.pixels + framebuffer.color.offset(x, y) : nullptr;
+
+						if (depth_buffer)
+							depth.set_quad(x, y);
+
+						// Quads never straddle screen tiles, so their whole cost goes to one tile
+						std::uint64_t quad_start = 0;
+
+						if constexpr (Instrumented)
+						{
+							++counters.quads;
+
+							if (heatmaps.tile_cost)
+								quad_start = heatmap_ticks();
+						}
+
+						float det01p[2][2];
+						float det12p[2][2];
+						float det20p[2][2];
+
+						// Perspective-correct barycentrics, [vertex][dy][dx]
+						float l[3][2][2];
+
+						for (int dy = 0; dy < 2; ++dy)
+						{
+							for (int dx = 0; dx < 2; ++dx)
+							{
+								vector4f p{x + dx + 0.5f, y + dy + 0.5f, 0.f, 0.f};
+
+								det01p[dy][dx] = det2D(v1.position - v0.position, p - v0.position);
+								det12p[dy][dx] = det2D(v2.position - v1.position, p - v1.position);
+								det20p[dy][dx] = det2D(v0.position - v2.position, p - v2.position);
+
+								l[0][dy][dx] = det12p[dy][dx] / det012 * v0.position.w;
+								l[1][dy][dx] = det20p[dy][dx] / det012 * v1.position.w;
+								l[2][dy][dx] = det01p[dy][dx] / det012 * v2.position.w;
+
+								float lsum = l[0][dy][dx] + l[1][dy][dx] + l[2][dy][dx];
+
+								l[0][dy][dx] /= lsum;
+								l[1][dy][dx] /= lsum;
+								l[2][dy][dx] /= lsum;
+							}
+						}
+
+						for (int dy = 0; dy < 2; ++dy)
+						{
+							for (int dx = 0; dx < 2; ++dx)
+							{
+								if (x + dx < xmin || x + dx > xmax)
+									continue;
+
+								if (y + dy < ymin || y + dy > ymax)
+									continue;
+
+								if (det01p[dy][dx] < 0.f || det12p[dy][dx] < 0.f || det20p[dy][dx] < 0.f)
+									continue;
+
+								if constexpr (Instrumented)
+								{
+									++counters.covered_pixels;
+
+									if (heatmaps.depth_tests)
+										++heatmaps.depth_tests.at(x + dx, y + dy);
+								}
+
+								auto ndc_position = l[0][dy][dx] * v0.position + l[1][dy][dx] * v1.position + l[2][dy][dx] * v2.position;
+
+								if (depth_buffer && !depth.test(command.depth, dx, dy, ndc_position.z))
+									continue;
+
+								if constexpr (Instrumented)
+								{
+									++counters.depth_passed_pixels;
+
+									if (heatmaps.writes && (framebuffer.color || (depth_buffer && command.depth.write)))
+										++heatmaps.writes.at(x + dx, y + dy);
+								}
+
+								if (!framebuffer.color)
+									continue;
+
+								if constexpr (Instrumented)
+								{
+									++counters.shaded_pixels;
+
+									if (heatmaps.shaded)
+										++heatmaps.shaded.at(x + dx, y + dy);
+								}
+
+								fragment<varyings_type> const pixel
+								{
+									.x = x + dx,
+									.y = y + dy,
+									.dx = dx,
+									.dy = dy,
+									.vertices = {&v0.varyings, &v1.varyings, &v2.varyings},
+									.weights = l,
+								};
+
+								color_quad[dx + dy * color_row_step] = to_color4ub(command.fragment_shader(pixel));
+							}
+						}
+
+						if constexpr (Instrumented)
+						{
+							if (heatmaps.tile_cost)
+								heatmaps.tile_cost.at(x / tile_size, y / tile_size) += heatmap_ticks() - quad_start;
+						}
+					}
+				}
+			}
+		}
+
+		if constexpr (Instrumented)
+		{
+			++counters.draws;
+			if (stats)
+				*stats += counters;
+		}
+	}
+
+	// Same as the built-in draw(), for user shaders
+	template <typename VertexShader, typename FragmentShader>
+	void draw(framebuffer const & framebuffer, viewport const & viewport, shader_command<VertexShader, FragmentShader> const & command, render_stats * stats = nullptr)
+	{
+		RASTERIZER_TRACE_ZONE("draw");
+
+		// Resolve the depth format & whether to collect stats or heatmaps once per draw, not per pixel
+		auto resolve_and_draw = [&]<bool Instrumented>(std::bool_constant<Instrumented>)
+		{
+			std::visit([&](auto const & depth_buffer){ rasterize<Instrumented>(framebuffer, depth_buffer, viewport, command, stats); }, framebuffer.depth);
+		};
+
+		if (stats || framebuffer.heatmaps)
+			resolve_and_draw(std::true_type{});
+		else
+			resolve_and_draw(std::false_type{});
+	}
+
+}
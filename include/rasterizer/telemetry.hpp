@@ -0,0 +1,97 @@
+#pragma once
+
+#include <rasterizer/image_view.hpp>
+#include <rasterizer/color.hpp>
+#include <rasterizer/bounded_queue.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rasterizer
+{
+
+	struct time_summary
+	{
+		float p50 = 0.f;
+		float p99 = 0.f;
+		float max = 0.f;
+		float mean = 0.f;
+		std::uint64_t samples = 0;
+	};
+
+	// Times of one thing done every frame, in milliseconds: the last history_size samples
+	// for rolling statistics, and a histogram of all of them with 4 buckets per doubling
+	// from 1/16 ms up to 4 s; adding a sample costs a few instructions and never allocates
+	struct time_series
+	{
+		static constexpr std::uint32_t history_size = 256;
+		static constexpr std::uint32_t bucket_count = 64;
+
+		char const * name = "";
+
+		float history[history_size] = {};
+		std::uint32_t buckets[bucket_count] = {};
+		std::uint64_t count = 0;
+		double total = 0.0;
+		float max = 0.f;
+
+		void add(float milliseconds);
+
+		// Over the samples still in the history
+		time_summary rolling() const;
+
+		// Over all samples, from the histogram: percentiles are bucket upper bounds,
+		// so they are accurate to within 19%; the mean & max are exact
+		time_summary overall() const;
+
+		// Smallest time that falls in the next bucket
+		static float bucket_upper_bound(std::uint32_t bucket);
+	};
+
+	// Named time series, e.g. the frame and each of its stages; not thread-safe, times
+	// measured on other threads are meant to be handed over and recorded by one thread
+	struct telemetry
+	{
+		std::vector<time_series> series;
+
+		// The name isn't copied, it must outlive the telemetry
+		std::size_t add_series(char const * name);
+
+		void record(std::size_t series_index, float milliseconds)
+		{
+			series[series_index].add(milliseconds);
+		}
+	};
+
+	// Draws a line of rolling statistics per series in the top-left corner, above a graph
+	// of the first series' history with a line at 16.7 ms, the budget at 60 frames per second
+	void draw_overlay(telemetry const & telemetry, image_view<color4ub> const & target);
+
+	// Appends a JSON line with the rolling & overall statistics of every series to a file
+	// every interval; lines are written on a background thread, and a snapshot taken while
+	// the previous one is still being written is dropped, so the caller never waits on I/O
+	struct telemetry_exporter
+	{
+		telemetry_exporter(std::filesystem::path const & path, std::chrono::duration<float> interval);
+		~telemetry_exporter();
+
+		telemetry_exporter(telemetry_exporter const &) = delete;
+		telemetry_exporter & operator = (telemetry_exporter const &) = delete;
+
+		// Call once per frame
+		void update(telemetry const & telemetry);
+
+		using clock = std::chrono::steady_clock;
+
+		clock::duration interval;
+		clock::time_point start;
+		clock::time_point next_export;
+		bounded_queue<std::string> lines{1};
+		std::thread writer;
+	};
+
+}
@@ -3,6 +3,7 @@
 #include <rasterizer/image.hpp>
 #include <rasterizer/color.hpp>
 
+#include <span>
 #include <vector>
 
 namespace rasterizer
@@ -28,6 +29,14 @@ namespace rasterizer
 		}
 	};
 
-	void generate_mipmaps(texture<color4ub> & texture);
+	struct thread_pool;
+
+	// Replaces all levels past the first one with a 2x2 box-filtered chain down to 1x1
+	// Rows of large levels are split across the pool if one is given
+	// New levels are allocated with the given memory options
+	void generate_mipmaps(texture<color4ub> & texture, thread_pool * pool = nullptr, memory_options const & memory = {});
+
+	// Processes a batch of textures in parallel, one texture per task
+	void generate_mipmaps(std::span<texture<color4ub>> textures, thread_pool & pool, memory_options const & memory = {});
 
 }
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <rasterizer/texture.hpp>
+#include <rasterizer/compressed_texture.hpp>
+
+#include <cstdint>
+#include <filesystem>
+
+namespace rasterizer
+{
+
+	// Texture container: a header, a level table, then every mipmap level stored
+	// exactly as it is sampled, each one aligned to texture_file_alignment bytes
+
+	enum class texture_file_format : std::uint32_t
+	{
+		rgba8 = 0,
+		bc1 = 1,
+		bc3 = 2,
+	};
+
+	constexpr std::uint32_t texture_file_alignment = 64;
+
+	struct texture_file_header
+	{
+		char magic[4] = {'R', 'T', 'E', 'X'};
+		std::uint32_t version = 1;
+		texture_file_format format = texture_file_format::rgba8;
+		std::uint32_t level_count = 0;
+		std::uint64_t source_hash = 0;
+	};
+
+	struct texture_file_level
+	{
+		std::uint64_t offset = 0;
+		std::uint64_t size = 0;
+		std::uint32_t width = 0;
+		std::uint32_t height = 0;
+	};
+
+	// Supported texture types: texture<color4ub>, compressed_texture<bc1_block>, compressed_texture<bc3_block>
+
+	// source_hash is stored for cache validation, see load_texture_cached
+	// Returns false if the file couldn't be written
+	template <typename Texture>
+	bool save_texture(std::filesystem::path const & path, Texture const & texture, std::uint64_t source_hash = 0);
+
+	// Memory-maps the file, levels point directly into the mapping which stays
+	// alive as long as any of them does
+	// Returns an empty texture if the file is missing, corrupt or of a different format
+	template <typename Texture>
+	Texture map_texture(std::filesystem::path const & path);
+
+	struct thread_pool;
+
+	// Loads an image file (JPEG, PNG, etc) with its full mipmap chain
+	// The first load stores a container in cache_directory, named after a hash of
+	// the source file's contents; later loads only map that container
+	texture<color4ub> load_texture_cached(std::filesystem::path const & path, std::filesystem::path const & cache_directory, thread_pool * pool = nullptr);
+
+	extern template bool save_texture(std::filesystem::path const &, texture<color4ub> const &, std::uint64_t);
+	extern template bool save_texture(std::filesystem::path const &, compressed_texture<bc1_block> const &, std::uint64_t);
+	extern template bool save_texture(std::filesystem::path const &, compressed_texture<bc3_block> const &, std::uint64_t);
+
+	extern template texture<color4ub> map_texture(std::filesystem::path const &);
+	extern template compressed_texture<bc1_block> map_texture(std::filesystem::path const &);
+	extern template compressed_texture<bc3_block> map_texture(std::filesystem::path const &);
+
+}
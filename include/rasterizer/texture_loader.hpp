@@ -0,0 +1,52 @@
+#pragma once
+
+#include <rasterizer/texture.hpp>
+#include <rasterizer/thread_pool.hpp>
+
+#include <filesystem>
+#include <future>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace rasterizer
+{
+
+	struct texture_load_options
+	{
+		bool generate_mipmaps = true;
+
+		// If set, loads go through load_texture_cached (which always generates mipmaps)
+		std::optional<std::filesystem::path> cache_directory = {};
+	};
+
+	// A texture that is possibly still being loaded in the background
+	// Failed loads end up as a texture without mipmaps
+	struct texture_handle
+	{
+		std::shared_future<texture<color4ub>> future;
+
+		bool ready() const
+		{
+			return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+		}
+
+		// Returns the placeholder until the texture is loaded, or if loading failed
+		texture<color4ub> const * get(texture<color4ub> const * placeholder) const
+		{
+			if (!ready() || future.get().mipmaps.empty())
+				return placeholder;
+			return &future.get();
+		}
+	};
+
+	// Every path is decoded by a separate task on the pool, so the calling thread
+	// returns immediately and can keep rendering with placeholders
+	std::vector<texture_handle> load_textures_async(std::span<std::filesystem::path const> paths, thread_pool & pool, texture_load_options const & options = {});
+
+	texture_handle load_texture_async(std::filesystem::path const & path, thread_pool & pool, texture_load_options const & options = {});
+
+	// 2x2 checkerboard (with its mipmaps), usable as a placeholder
+	texture<color4ub> make_checkerboard_texture(color4ub color0, color4ub color1);
+
+}
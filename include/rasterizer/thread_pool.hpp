@@ -0,0 +1,55 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace rasterizer
+{
+
+	struct thread_pool
+	{
+		explicit thread_pool(std::uint32_t thread_count = std::thread::hardware_concurrency());
+		~thread_pool();
+
+		thread_pool(thread_pool const &) = delete;
+		thread_pool & operator = (thread_pool const &) = delete;
+
+		std::uint32_t thread_count() const
+		{
+			return threads.size();
+		}
+
+		template <typename Function>
+		auto submit(Function && function) -> std::future<std::invoke_result_t<Function>>
+		{
+			using result_type = std::invoke_result_t<Function>;
+
+			auto task = std::make_shared<std::packaged_task<result_type()>>(std::forward<Function>(function));
+			auto result = task->get_future();
+			push([task]{ (*task)(); });
+			return result;
+		}
+
+		// Splits [0, count) into chunks processed by the workers and the calling thread,
+		// returns once all of them are done
+		// Safe to call from a worker: the caller processes whatever chunks nobody else picked up
+		void parallel_for(std::uint32_t count, std::function<void(std::uint32_t begin, std::uint32_t end)> const & function);
+
+		void push(std::function<void()> task);
+
+		std::vector<std::thread> threads;
+		std::mutex mutex;
+		std::condition_variable condition;
+		std::deque<std::function<void()>> tasks;
+		bool stopping = false;
+	};
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <rasterizer/perf_counters.hpp>
+
+#include <cstdint>
+#include <filesystem>
+
+// Timeline instrumentation: zones are timed scopes recorded into per-thread ring buffers,
+// which can be dumped as a Chrome trace at any time and opened in chrome://tracing or Perfetto
+// Zones are only compiled in when RASTERIZER_TRACE is defined to 1 (the RASTERIZER_TRACE
+// CMake option), otherwise RASTERIZER_TRACE_ZONE expands to nothing
+
+#if defined(RASTERIZER_TRACE) && RASTERIZER_TRACE
+#define RASTERIZER_TRACE_CONCAT_IMPL(a, b) a##b
+#define RASTERIZER_TRACE_CONCAT(a, b) RASTERIZER_TRACE_CONCAT_IMPL(a, b)
+#define RASTERIZER_TRACE_ZONE(name) ::rasterizer::trace::zone RASTERIZER_TRACE_CONCAT(rasterizer_trace_zone_, __LINE__){name}
+#else
+#define RASTERIZER_TRACE_ZONE(name) do {} while (false)
+#endif
+
+namespace rasterizer::trace
+{
+
+#if defined(RASTERIZER_TRACE) && RASTERIZER_TRACE
+	inline constexpr bool enabled = true;
+#else
+	inline constexpr bool enabled = false;
+#endif
+
+	// Zones and counter samples each thread keeps, older ones are overwritten
+	inline constexpr std::uint32_t ring_capacity = 1 << 16;
+	inline constexpr std::uint32_t counter_ring_capacity = 1 << 12;
+
+	// Nanoseconds since the first call in the process
+	std::uint64_t now();
+
+	// Appends a finished zone to the calling thread's ring buffer without taking any lock,
+	// except to register the thread on its first event
+	// The name isn't copied, it must be a string literal or otherwise outlive the trace
+	void record(char const * name, std::uint64_t begin, std::uint64_t end);
+
+	// Appends hardware counter values measured over some work, shown as a counter track
+	// named after the work & the thread; the name has the same lifetime as zone names
+	void record_counters(char const * name, std::uint64_t time, perf_values const & values);
+
+	// Shows the calling thread under this name instead of its number; same lifetime as zone names
+	// Does nothing with tracing compiled out, so it can be called unconditionally
+	void set_thread_name(char const * name);
+
+	// Writes the events currently held by every thread's buffer as Chrome trace JSON;
+	// threads keep recording meanwhile, events overwritten while writing are left out
+	// Returns false if the file couldn't be written; with tracing compiled out, the trace is empty
+	bool write_chrome_trace(std::filesystem::path const & path);
+
+	struct zone
+	{
+		char const * name;
+		std::uint64_t begin = now();
+
+		~zone()
+		{
+			record(name, begin, now());
+		}
+	};
+
+}
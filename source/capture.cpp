@@ -0,0 +1,1001 @@
+#include <rasterizer/capture.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace rasterizer::capture
+{
+
+	namespace
+	{
+
+		// File layout: the magic, then records made of a record_type byte and its fields,
+		// all stored in native (little-endian) byte order
+		constexpr char magic[8] = {'T', 'R', 'C', 'A', 'P', 'T', '0', '1'};
+
+		enum class record_type : std::uint8_t
+		{
+			// id, buffer_format, width, height, pitch, layout; written before the first call using the buffer
+			buffer = 1,
+			// hash, size, bytes; vertex attributes & indices
+			blob,
+			// hash, texture_format, level count, then per level width, height, layout & texels
+			texture,
+			// buffer id, color
+			clear_color,
+			// buffer id, raw value
+			clear_depth,
+			// color & depth buffer ids, viewport, then the draw_command
+			draw,
+			end_frame,
+		};
+
+		enum class buffer_format : std::uint8_t
+		{
+			color,
+			depth32,
+			depth16,
+			depth24,
+			depth_float,
+			depth_compressed,
+		};
+
+		enum class texture_format : std::uint8_t
+		{
+			rgba8,
+			bc1,
+			bc3,
+		};
+
+		constexpr std::uint32_t no_buffer = ~std::uint32_t(0);
+
+		// Hash of 0 means no data
+		std::uint64_t hash(void const * data, std::size_t size)
+		{
+			auto bytes = (unsigned char const *)data;
+
+			std::uint64_t h = 0x9e3779b97f4a7c15ull ^ size;
+
+			auto mix = [&h](std::uint64_t word)
+			{
+				h ^= word;
+				h *= 0xff51afd7ed558ccdull;
+				h ^= h >> 32;
+			};
+
+			std::size_t i = 0;
+			for (; i + 8 <= size; i += 8)
+			{
+				std::uint64_t word;
+				std::memcpy(&word, bytes + i, 8);
+				mix(word);
+			}
+
+			std::uint64_t tail = 0;
+			std::memcpy(&tail, bytes + i, size - i);
+			mix(tail);
+
+			return h == 0 ? 1 : h;
+		}
+
+		template <typename T>
+		void put(std::ofstream & file, T const & value)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			file.write((char const *)&value, sizeof(T));
+		}
+
+		template <typename Pixel>
+		std::span<std::byte const> storage_bytes(image<Pixel> const & level)
+		{
+			return {(std::byte const *)level.pixels.get(), level.view().storage_size() * sizeof(Pixel)};
+		}
+
+		template <typename Block>
+		std::span<std::byte const> storage_bytes(compressed_image<Block> const & level)
+		{
+			return {(std::byte const *)level.blocks.get(), std::size_t(level.width_in_blocks()) * level.height_in_blocks() * sizeof(Block)};
+		}
+
+		// Texels as stored in the file, row after row
+		image_view<color4ub> linear_view(void * texels, std::uint32_t width, std::uint32_t height)
+		{
+			return {.pixels = (color4ub *)texels, .width = width, .height = height, .pitch = width, .layout = image_layout::linear};
+		}
+
+		template <typename Pixel>
+		constexpr buffer_format format_of()
+		{
+			if constexpr (std::is_same_v<Pixel, color4ub>)
+				return buffer_format::color;
+			else if constexpr (std::is_same_v<Pixel, std::uint32_t>)
+				return buffer_format::depth32;
+			else if constexpr (std::is_same_v<Pixel, std::uint16_t>)
+				return buffer_format::depth16;
+			else if constexpr (std::is_same_v<Pixel, depth24>)
+				return buffer_format::depth24;
+			else
+				return buffer_format::depth_float;
+		}
+
+		struct known_buffer
+		{
+			std::uint32_t id;
+			buffer_format format;
+			std::uint32_t width;
+			std::uint32_t height;
+		};
+
+		struct known_texture
+		{
+			void const * first_level;
+			std::uint64_t hash;
+		};
+
+		struct writer
+		{
+			std::mutex mutex;
+			std::atomic<bool> active{false};
+			std::ofstream file;
+
+			// Buffers are identified by their storage; a different buffer reusing the same
+			// storage address gets a new id
+			std::unordered_map<void const *, known_buffer> buffers;
+			std::uint32_t next_buffer_id = 0;
+
+			std::unordered_set<std::uint64_t> blobs;
+			std::unordered_map<void const *, known_texture> textures;
+
+			bool calls_in_frame = false;
+
+			std::vector<std::byte> scratch;
+
+			void reset()
+			{
+				buffers.clear();
+				next_buffer_id = 0;
+				blobs.clear();
+				textures.clear();
+				calls_in_frame = false;
+			}
+
+			void finish_frame()
+			{
+				if (calls_in_frame)
+					put(file, record_type::end_frame);
+				calls_in_frame = false;
+			}
+
+			std::uint32_t buffer_id(void const * storage, buffer_format format, std::uint32_t width, std::uint32_t height, std::uint32_t pitch, image_layout layout)
+			{
+				if (!storage)
+					return no_buffer;
+
+				auto it = buffers.find(storage);
+				if (it != buffers.end() && it->second.format == format && it->second.width == width && it->second.height == height)
+					return it->second.id;
+
+				known_buffer buffer{.id = next_buffer_id++, .format = format, .width = width, .height = height};
+				buffers[storage] = buffer;
+
+				put(file, record_type::buffer);
+				put(file, buffer.id);
+				put(file, format);
+				put(file, width);
+				put(file, height);
+				put(file, pitch);
+				put(file, layout);
+
+				return buffer.id;
+			}
+
+			template <typename Pixel>
+			std::uint32_t buffer_id(image_view<Pixel> const & view)
+			{
+				return buffer_id(view.pixels, format_of<Pixel>(), view.width, view.height, (std::uint32_t)view.row_pitch(), view.layout);
+			}
+
+			std::uint32_t buffer_id(compressed_depth_view const & view)
+			{
+				return buffer_id(view.tiles.pixels, buffer_format::depth_compressed, view.width, view.height, 0, image_layout::tiled);
+			}
+
+			std::uint32_t buffer_id(depth_view const & view)
+			{
+				return std::visit([this](auto const & view){ return buffer_id(view); }, view);
+			}
+
+			std::uint64_t write_blob(void const * data, std::size_t size)
+			{
+				auto h = hash(data, size);
+
+				if (blobs.insert(h).second)
+				{
+					put(file, record_type::blob);
+					put(file, h);
+					put(file, std::uint64_t(size));
+					file.write((char const *)data, size);
+				}
+
+				return h;
+			}
+
+			// Gathers the vertices the draw reads into a packed array of decoded values;
+			// attributes with a stride of 0 or pointing to the mesh defaults are stored as a single value
+			template <typename T>
+			std::pair<std::uint64_t, bool> write_attribute(attribute<T> const & attribute, T const & default_value, std::uint32_t vertex_count)
+			{
+				if (!attribute.pointer)
+					return {0, false};
+
+				bool per_vertex = attribute.stride != 0 && attribute.pointer != &default_value;
+				std::uint32_t count = per_vertex ? vertex_count : 1;
+
+				scratch.resize(std::size_t(count) * sizeof(T));
+				for (std::uint32_t i = 0; i < count; ++i)
+				{
+					T value = attribute[i];
+					std::memcpy(scratch.data() + std::size_t(i) * sizeof(T), &value, sizeof(T));
+				}
+
+				return {write_blob(scratch.data(), scratch.size()), per_vertex};
+			}
+
+			// Texels in row order whatever the layout, detiled into scratch & written at once
+			void write_level(image<color4ub> const & level)
+			{
+				put(file, level.width);
+				put(file, level.height);
+				put(file, level.layout);
+
+				scratch.resize(std::size_t(level.width) * level.height * sizeof(color4ub));
+				copy(level.view(), linear_view(scratch.data(), level.width, level.height));
+				file.write((char const *)scratch.data(), scratch.size());
+			}
+
+			template <typename Block>
+			void write_level(compressed_image<Block> const & level)
+			{
+				put(file, level.width);
+				put(file, level.height);
+				put(file, image_layout::linear);
+
+				auto bytes = storage_bytes(level);
+				file.write((char const *)bytes.data(), bytes.size());
+			}
+
+			template <typename Texture>
+			std::uint64_t write_texture(Texture const & texture, texture_format format)
+			{
+				void const * first_level = texture.mipmaps.empty() ? nullptr : storage_bytes(texture.mipmaps.front()).data();
+
+				auto it = textures.find(&texture);
+				if (it != textures.end() && it->second.first_level == first_level)
+					return it->second.hash;
+
+				std::uint64_t h = 0x5bd1e995ull ^ texture.mipmaps.size();
+				for (auto const & level : texture.mipmaps)
+				{
+					auto bytes = storage_bytes(level);
+					h = h * 31 + hash(bytes.data(), bytes.size());
+				}
+				h = h == 0 ? 1 : h;
+
+				textures[&texture] = {first_level, h};
+
+				if (blobs.insert(h).second)
+				{
+					put(file, record_type::texture);
+					put(file, h);
+					put(file, format);
+					put(file, std::uint32_t(texture.mipmaps.size()));
+					for (auto const & level : texture.mipmaps)
+						write_level(level);
+				}
+
+				return h;
+			}
+		};
+
+		writer & the_writer()
+		{
+			static writer instance;
+			return instance;
+		}
+
+	}
+
+	bool start(std::filesystem::path const & path)
+	{
+		auto & writer = the_writer();
+		std::lock_guard lock(writer.mutex);
+
+		if (writer.active)
+		{
+			writer.finish_frame();
+			writer.file.close();
+		}
+
+		writer.reset();
+		writer.file = std::ofstream(path, std::ios::binary);
+		writer.file.write(magic, sizeof(magic));
+
+		writer.active = bool(writer.file);
+		return writer.active;
+	}
+
+	void stop()
+	{
+		auto & writer = the_writer();
+		std::lock_guard lock(writer.mutex);
+
+		if (!writer.active)
+			return;
+
+		writer.finish_frame();
+		writer.file.close();
+		writer.active = false;
+		writer.reset();
+	}
+
+	bool active()
+	{
+		return the_writer().active.load(std::memory_order_relaxed);
+	}
+
+	void end_frame()
+	{
+		auto & writer = the_writer();
+		if (!writer.active.load(std::memory_order_relaxed))
+			return;
+
+		std::lock_guard lock(writer.mutex);
+		if (writer.active)
+			writer.finish_frame();
+	}
+
+	void record_clear(image_view<color4ub> const & color_buffer, vector4f const & color)
+	{
+		auto & writer = the_writer();
+		std::lock_guard lock(writer.mutex);
+		if (!writer.active)
+			return;
+
+		auto id = writer.buffer_id(color_buffer);
+		put(writer.file, record_type::clear_color);
+		put(writer.file, id);
+		put(writer.file, color);
+		writer.calls_in_frame = true;
+	}
+
+	void record_clear(depth_view const & depth_buffer, std::uint32_t raw_value)
+	{
+		auto & writer = the_writer();
+		std::lock_guard lock(writer.mutex);
+		if (!writer.active)
+			return;
+
+		auto id = writer.buffer_id(depth_buffer);
+		put(writer.file, record_type::clear_depth);
+		put(writer.file, id);
+		put(writer.file, raw_value);
+		writer.calls_in_frame = true;
+	}
+
+	void record_draw(framebuffer const & framebuffer, viewport const & viewport, draw_command const & command)
+	{
+		auto & writer = the_writer();
+		std::lock_guard lock(writer.mutex);
+		if (!writer.active)
+			return;
+
+		auto const & mesh = command.mesh;
+
+		// Everything referenced goes first, so that the draw record only holds ids & hashes
+		auto color_id = writer.buffer_id(framebuffer.color);
+		auto depth_id = writer.buffer_id(framebuffer.depth);
+
+		std::uint32_t vertex_count = mesh.count;
+		std::uint64_t indices_hash = 0;
+
+		if (mesh.indices)
+		{
+			vertex_count = mesh.count == 0 ? 0 : *std::max_element(mesh.indices, mesh.indices + mesh.count) + 1;
+			indices_hash = writer.write_blob(mesh.indices, std::size_t(mesh.count) * sizeof(std::uint32_t));
+		}
+
+		auto positions = writer.write_attribute(mesh.positions, vector3f{}, vertex_count);
+		auto normals = writer.write_attribute(mesh.normals, mesh::default_normal, vertex_count);
+		auto colors = writer.write_attribute(mesh.colors, mesh::default_color, vertex_count);
+		auto texcoords = writer.write_attribute(mesh.texcoords, mesh::default_texcoord, vertex_count);
+
+		std::uint64_t texture_hash = 0;
+		texture_format format = texture_format::rgba8;
+
+		if (command.albedo)
+		{
+			std::visit([&](auto const * albedo)
+			{
+				using texture_type = std::remove_cvref_t<decltype(*albedo)>;
+
+				if constexpr (std::is_same_v<texture_type, texture<color4ub>>)
+					format = texture_format::rgba8;
+				else if constexpr (std::is_same_v<texture_type, compressed_texture<bc1_block>>)
+					format = texture_format::bc1;
+				else
+					format = texture_format::bc3;
+
+				if (albedo)
+					texture_hash = writer.write_texture(*albedo, format);
+			}, command.albedo->texture);
+		}
+
+		auto & file = writer.file;
+
+		put(file, record_type::draw);
+		put(file, color_id);
+		put(file, depth_id);
+		put(file, viewport);
+
+		for (auto const & [attribute_hash, per_vertex] : {positions, normals, colors, texcoords})
+		{
+			put(file, attribute_hash);
+			put(file, std::uint8_t(per_vertex));
+		}
+		put(file, indices_hash);
+		put(file, mesh.count);
+
+		put(file, command.cull_mode);
+		put(file, command.depth);
+		put(file, command.model);
+		put(file, command.view);
+		put(file, command.projection);
+
+		put(file, std::uint8_t(command.lights.has_value()));
+		if (command.lights)
+		{
+			put(file, command.lights->ambient_light);
+			put(file, std::uint32_t(command.lights->directional_lights.size()));
+			file.write((char const *)command.lights->directional_lights.data(), command.lights->directional_lights.size_bytes());
+			put(file, std::uint32_t(command.lights->point_lights.size()));
+			file.write((char const *)command.lights->point_lights.data(), command.lights->point_lights.size_bytes());
+		}
+
+		put(file, std::uint8_t(command.albedo.has_value()));
+		if (command.albedo)
+		{
+			put(file, texture_hash);
+			put(file, format);
+			put(file, command.albedo->sampler);
+		}
+
+		writer.calls_in_frame = true;
+	}
+
+	namespace
+	{
+
+		using buffer = std::variant
+		<
+			image<color4ub>,
+			image<std::uint32_t>,
+			image<std::uint16_t>,
+			image<depth24>,
+			image<float>,
+			compressed_depth_buffer
+		>;
+
+		using loaded_texture = std::variant
+		<
+			texture<color4ub>,
+			compressed_texture<bc1_block>,
+			compressed_texture<bc3_block>
+		>;
+
+		struct call
+		{
+			record_type type;
+			std::uint32_t color_buffer = no_buffer;
+			std::uint32_t depth_buffer = no_buffer;
+
+			vector4f clear_color = {};
+			std::uint32_t clear_value = 0;
+
+			struct viewport viewport = {};
+			draw_command command = {};
+
+			// Referenced by the command's light spans
+			std::vector<directional_light> directional_lights = {};
+			std::vector<point_light> point_lights = {};
+		};
+
+		struct reader
+		{
+			std::vector<char> data;
+			std::size_t position = 0;
+
+			template <typename T>
+			bool get(T & value)
+			{
+				if (data.size() - position < sizeof(T))
+					return false;
+
+				std::memcpy(&value, data.data() + position, sizeof(T));
+				position += sizeof(T);
+				return true;
+			}
+
+			bool get_bytes(void * destination, std::size_t size)
+			{
+				if (data.size() - position < size)
+					return false;
+
+				std::memcpy(destination, data.data() + position, size);
+				position += size;
+				return true;
+			}
+
+			// Moves past size bytes, to come back to them later; position never passes the end,
+			// which the checks above rely on
+			bool skip(std::size_t size)
+			{
+				if (data.size() - position < size)
+					return false;
+
+				position += size;
+				return true;
+			}
+		};
+
+		template <typename Pixel>
+		buffer allocate_buffer(std::uint32_t width, std::uint32_t height, std::uint32_t pitch, image_layout layout)
+		{
+			auto result = image<Pixel>::allocate(width, height, {.layout = layout});
+
+			// Recorded buffers with padded rows were most likely allocated with pad_rows
+			if (pitch > result.view().row_pitch())
+				result = image<Pixel>::allocate(width, height, {.layout = layout, .pad_rows = true});
+
+			return result;
+		}
+
+		bool read_level(reader & reader, image<color4ub> & level)
+		{
+			std::uint32_t width, height;
+			image_layout layout;
+
+			if (!reader.get(width) || !reader.get(height) || !reader.get(layout) || layout > image_layout::tiled)
+				return false;
+
+			std::size_t const size = std::size_t(width) * height * sizeof(color4ub);
+
+			if (reader.data.size() - reader.position < size)
+				return false;
+
+			level = image<color4ub>::allocate(width, height, {.layout = layout});
+			copy(linear_view(reader.data.data() + reader.position, width, height), level.view());
+
+			return reader.skip(size);
+		}
+
+		template <typename Block>
+		bool read_level(reader & reader, compressed_image<Block> & level)
+		{
+			std::uint32_t width, height;
+			image_layout layout;
+
+			if (!reader.get(width) || !reader.get(height) || !reader.get(layout))
+				return false;
+
+			std::size_t size = std::size_t((width + 3) / 4) * ((height + 3) / 4) * sizeof(Block);
+
+			if (reader.data.size() - reader.position < size)
+				return false;
+
+			level = compressed_image<Block>::allocate(width, height);
+			return reader.get_bytes(level.blocks.get(), size);
+		}
+
+		template <typename Texture>
+		bool read_texture(reader & reader, std::uint32_t level_count, Texture & texture)
+		{
+			texture.mipmaps.resize(level_count);
+
+			for (auto & level : texture.mipmaps)
+				if (!read_level(reader, level))
+					return false;
+
+			return true;
+		}
+
+	}
+
+	struct replay::state
+	{
+		std::vector<buffer> buffers;
+		std::vector<std::uint32_t> color_buffers;
+
+		// Values of unordered maps stay in place, so draw commands point right into them
+		std::unordered_map<std::uint64_t, std::vector<std::byte>> blobs;
+		std::unordered_map<std::uint64_t, loaded_texture> textures;
+
+		std::vector<call> calls;
+
+		// Frame i is made of calls [frame_begins[i], frame_begins[i + 1])
+		std::vector<std::size_t> frame_begins;
+
+		bool is_color(std::uint32_t id) const
+		{
+			return id < buffers.size() && std::holds_alternative<image<color4ub>>(buffers[id]);
+		}
+
+		bool is_depth(std::uint32_t id) const
+		{
+			return id < buffers.size() && !std::holds_alternative<image<color4ub>>(buffers[id]);
+		}
+
+		template <typename T>
+		bool read_attribute(reader & reader, std::uint32_t vertex_count, attribute<T> & result)
+		{
+			std::uint64_t blob_hash;
+			std::uint8_t per_vertex;
+
+			if (!reader.get(blob_hash) || !reader.get(per_vertex))
+				return false;
+
+			if (blob_hash == 0)
+			{
+				result = {};
+				return true;
+			}
+
+			auto blob = blobs.find(blob_hash);
+			if (blob == blobs.end() || blob->second.size() < (per_vertex ? std::size_t(vertex_count) : 1) * sizeof(T))
+				return false;
+
+			result = {.pointer = blob->second.data(), .stride = per_vertex ? std::uint32_t(sizeof(T)) : 0};
+			return true;
+		}
+
+		bool read_draw(reader & reader, call & call)
+		{
+			if (!reader.get(call.color_buffer) || !reader.get(call.depth_buffer) || !reader.get(call.viewport))
+				return false;
+
+			if ((call.color_buffer != no_buffer && !is_color(call.color_buffer)) || (call.depth_buffer != no_buffer && !is_depth(call.depth_buffer)))
+				return false;
+
+			// Attributes come before the indices they're validated against
+			auto attributes_position = reader.position;
+			if (!reader.skip(4 * (sizeof(std::uint64_t) + sizeof(std::uint8_t))))
+				return false;
+
+			auto & mesh = call.command.mesh;
+
+			std::uint64_t indices_hash;
+			if (!reader.get(indices_hash) || !reader.get(mesh.count))
+				return false;
+
+			std::uint32_t vertex_count = mesh.count;
+
+			if (indices_hash != 0)
+			{
+				auto blob = blobs.find(indices_hash);
+				if (blob == blobs.end() || blob->second.size() != std::size_t(mesh.count) * sizeof(std::uint32_t))
+					return false;
+
+				mesh.indices = (std::uint32_t const *)blob->second.data();
+				vertex_count = mesh.count == 0 ? 0 : *std::max_element(mesh.indices, mesh.indices + mesh.count) + 1;
+			}
+
+			auto end_of_mesh = reader.position;
+			reader.position = attributes_position;
+
+			if (!read_attribute(reader, vertex_count, mesh.positions)
+				|| !read_attribute(reader, vertex_count, mesh.normals)
+				|| !read_attribute(reader, vertex_count, mesh.colors)
+				|| !read_attribute(reader, vertex_count, mesh.texcoords))
+				return false;
+
+			reader.position = end_of_mesh;
+
+			auto & command = call.command;
+
+			if (!reader.get(command.cull_mode) || !reader.get(command.depth) || !reader.get(command.model) || !reader.get(command.view) || !reader.get(command.projection))
+				return false;
+
+			std::uint8_t has_lights;
+			if (!reader.get(has_lights))
+				return false;
+
+			if (has_lights)
+			{
+				light_settings lights;
+				std::uint32_t count;
+
+				if (!reader.get(lights.ambient_light) || !reader.get(count) || count > (reader.data.size() - reader.position) / sizeof(directional_light))
+					return false;
+
+				call.directional_lights.resize(count);
+				if (!reader.get_bytes(call.directional_lights.data(), count * sizeof(directional_light)))
+					return false;
+
+				if (!reader.get(count) || count > (reader.data.size() - reader.position) / sizeof(point_light))
+					return false;
+
+				call.point_lights.resize(count);
+				if (!reader.get_bytes(call.point_lights.data(), count * sizeof(point_light)))
+					return false;
+
+				lights.directional_lights = call.directional_lights;
+				lights.point_lights = call.point_lights;
+				command.lights = lights;
+			}
+
+			std::uint8_t has_albedo;
+			if (!reader.get(has_albedo))
+				return false;
+
+			if (has_albedo)
+			{
+				std::uint64_t texture_hash;
+				texture_format format;
+				sampler sampler;
+
+				if (!reader.get(texture_hash) || !reader.get(format) || !reader.get(sampler))
+					return false;
+
+				texture_and_sampler albedo{.texture = {}, .sampler = sampler};
+
+				if (texture_hash == 0)
+				{
+					if (format == texture_format::bc1)
+						albedo.texture = (compressed_texture<bc1_block> const *)nullptr;
+					else if (format == texture_format::bc3)
+						albedo.texture = (compressed_texture<bc3_block> const *)nullptr;
+				}
+				else
+				{
+					auto texture = textures.find(texture_hash);
+					if (texture == textures.end())
+						return false;
+
+					std::visit([&albedo](auto const & loaded){ albedo.texture = &loaded; }, texture->second);
+				}
+
+				command.albedo = albedo;
+			}
+
+			return true;
+		}
+
+		bool read_record(reader & reader, record_type type)
+		{
+			switch (type)
+			{
+			case record_type::buffer:
+			{
+				std::uint32_t id, width, height, pitch;
+				buffer_format format;
+				image_layout layout;
+
+				if (!reader.get(id) || !reader.get(format) || !reader.get(width) || !reader.get(height) || !reader.get(pitch) || !reader.get(layout))
+					return false;
+
+				if (id != buffers.size() || layout > image_layout::tiled)
+					return false;
+
+				switch (format)
+				{
+				case buffer_format::color:
+					buffers.push_back(allocate_buffer<color4ub>(width, height, pitch, layout));
+					color_buffers.push_back(id);
+					return true;
+				case buffer_format::depth32:
+					buffers.push_back(allocate_buffer<std::uint32_t>(width, height, pitch, layout));
+					return true;
+				case buffer_format::depth16:
+					buffers.push_back(allocate_buffer<std::uint16_t>(width, height, pitch, layout));
+					return true;
+				case buffer_format::depth24:
+					buffers.push_back(allocate_buffer<depth24>(width, height, pitch, layout));
+					return true;
+				case buffer_format::depth_float:
+					buffers.push_back(allocate_buffer<float>(width, height, pitch, layout));
+					return true;
+				case buffer_format::depth_compressed:
+					buffers.push_back(compressed_depth_buffer::allocate(width, height));
+					return true;
+				}
+
+				return false;
+			}
+			case record_type::blob:
+			{
+				std::uint64_t blob_hash, size;
+
+				if (!reader.get(blob_hash) || !reader.get(size) || size > reader.data.size() - reader.position)
+					return false;
+
+				auto & blob = blobs[blob_hash];
+				blob.resize(size);
+				return reader.get_bytes(blob.data(), size);
+			}
+			case record_type::texture:
+			{
+				std::uint64_t texture_hash;
+				texture_format format;
+				std::uint32_t level_count;
+
+				if (!reader.get(texture_hash) || !reader.get(format) || !reader.get(level_count) || level_count > 32)
+					return false;
+
+				switch (format)
+				{
+				case texture_format::rgba8:
+					return read_texture(reader, level_count, std::get<0>(textures[texture_hash] = texture<color4ub>{}));
+				case texture_format::bc1:
+					return read_texture(reader, level_count, std::get<1>(textures[texture_hash] = compressed_texture<bc1_block>{}));
+				case texture_format::bc3:
+					return read_texture(reader, level_count, std::get<2>(textures[texture_hash] = compressed_texture<bc3_block>{}));
+				}
+
+				return false;
+			}
+			case record_type::clear_color:
+			{
+				call call{.type = type};
+
+				if (!reader.get(call.color_buffer) || !reader.get(call.clear_color) || !is_color(call.color_buffer))
+					return false;
+
+				calls.push_back(std::move(call));
+				return true;
+			}
+			case record_type::clear_depth:
+			{
+				call call{.type = type};
+
+				if (!reader.get(call.depth_buffer) || !reader.get(call.clear_value) || !is_depth(call.depth_buffer))
+					return false;
+
+				calls.push_back(std::move(call));
+				return true;
+			}
+			case record_type::draw:
+			{
+				call call{.type = type};
+
+				if (!read_draw(reader, call))
+					return false;
+
+				calls.push_back(std::move(call));
+				return true;
+			}
+			case record_type::end_frame:
+				frame_begins.push_back(calls.size());
+				return true;
+			}
+
+			return false;
+		}
+	};
+
+	replay replay::load(std::filesystem::path const & path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+			return {};
+
+		reader reader;
+		reader.data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+		char file_magic[sizeof(magic)];
+		if (!reader.get_bytes(file_magic, sizeof(magic)) || std::memcmp(file_magic, magic, sizeof(magic)) != 0)
+			return {};
+
+		auto data = std::make_shared<state>();
+		data->frame_begins.push_back(0);
+
+		// A capture cut short, e.g. by a crash, keeps its complete frames; stop() ends the last
+		// frame, so calls past the last end_frame record are from a frame that was cut short,
+		// even when the cut falls between two records
+		record_type type;
+		bool complete = true;
+
+		while (complete && reader.get(type))
+			complete = data->read_record(reader, type);
+
+		data->calls.resize(data->frame_begins.back());
+
+		if (data->frame_begins.size() < 2)
+			return {};
+
+		return replay{std::move(data)};
+	}
+
+	std::size_t replay::frame_count() const
+	{
+		return data->frame_begins.size() - 1;
+	}
+
+	std::size_t replay::draw_count(std::size_t frame) const
+	{
+		auto begin = data->calls.begin() + data->frame_begins[frame];
+		auto end = data->calls.begin() + data->frame_begins[frame + 1];
+		return std::count_if(begin, end, [](call const & call){ return call.type == record_type::draw; });
+	}
+
+	void replay::play(std::size_t frame, render_stats * stats) const
+	{
+		auto view_of_depth = [this](std::uint32_t id) -> depth_view
+		{
+			if (id == no_buffer)
+				return image_view<std::uint32_t>{};
+
+			return std::visit([](auto const & buffer) -> depth_view
+			{
+				if constexpr (std::is_same_v<std::remove_cvref_t<decltype(buffer)>, image<color4ub>>)
+					return image_view<std::uint32_t>{};
+				else
+					return buffer.view();
+			}, data->buffers[id]);
+		};
+
+		auto view_of_color = [this](std::uint32_t id)
+		{
+			if (id == no_buffer)
+				return image_view<color4ub>{};
+			return std::get<image<color4ub>>(data->buffers[id]).view();
+		};
+
+		for (auto i = data->frame_begins[frame]; i < data->frame_begins[frame + 1]; ++i)
+		{
+			auto const & call = data->calls[i];
+
+			switch (call.type)
+			{
+			case record_type::clear_color:
+				clear(view_of_color(call.color_buffer), call.clear_color);
+				break;
+			case record_type::clear_depth:
+				std::visit([value = call.clear_value](auto const & depth_buffer)
+				{
+					using view_type = std::remove_cvref_t<decltype(depth_buffer)>;
+
+					if constexpr (std::is_same_v<view_type, image_view<std::uint16_t>>)
+						clear(depth_buffer, std::uint16_t(value));
+					else if constexpr (std::is_same_v<view_type, image_view<float>> || std::is_same_v<view_type, compressed_depth_view>)
+						clear(depth_buffer, std::bit_cast<float>(value));
+					else
+						clear(depth_buffer, value);
+				}, view_of_depth(call.depth_buffer));
+				break;
+			case record_type::draw:
+				draw(framebuffer{.color = view_of_color(call.color_buffer), .depth = view_of_depth(call.depth_buffer)}, call.viewport, call.command, stats);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	std::size_t replay::color_buffer_count() const
+	{
+		return data->color_buffers.size();
+	}
+
+	image_view<color4ub> replay::color_buffer(std::size_t index) const
+	{
+		return std::get<image<color4ub>>(data->buffers[data->color_buffers[index]]).view();
+	}
+
+}
@@ -0,0 +1,108 @@
+#include <rasterizer/color.hpp>
+
+#include "image_runs.hpp"
+
+namespace rasterizer
+{
+
+	namespace
+	{
+
+		constexpr std::array<float, 256> make_unorm8_table()
+		{
+			std::array<float, 256> result;
+			for (int i = 0; i < 256; ++i)
+				result[i] = i / 255.f;
+			return result;
+		}
+
+		std::array<float, 256> make_srgb8_table()
+		{
+			std::array<float, 256> result;
+			for (int i = 0; i < 256; ++i)
+			{
+				float c = i / 255.f;
+				result[i] = (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+			return result;
+		}
+
+	}
+
+	std::array<float, 256> const unorm8_to_float = make_unorm8_table();
+	std::array<float, 256> const srgb8_to_linear = make_srgb8_table();
+
+	void to_vector4f(color4ub const * source, vector4f * destination, std::size_t count)
+	{
+		std::size_t i = 0;
+
+#if defined(__SSE2__)
+		__m128i const zero = _mm_setzero_si128();
+		__m128 const scale = _mm_set1_ps(255.f);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i pixels = _mm_loadu_si128((__m128i const *)(source + i));
+			__m128i lo = _mm_unpacklo_epi8(pixels, zero);
+			__m128i hi = _mm_unpackhi_epi8(pixels, zero);
+
+			// Division rather than multiplication by 1/255 to match the tables exactly
+			_mm_storeu_ps(&destination[i + 0].x, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+			_mm_storeu_ps(&destination[i + 1].x, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+			_mm_storeu_ps(&destination[i + 2].x, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+			_mm_storeu_ps(&destination[i + 3].x, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+		}
+#endif
+
+		for (; i < count; ++i)
+			destination[i] = to_vector4f(source[i]);
+	}
+
+	void to_vector4f_srgb(color4ub const * source, vector4f * destination, std::size_t count)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+			destination[i] = to_vector4f_srgb(source[i]);
+	}
+
+	void to_color4ub(vector4f const * source, color4ub * destination, std::size_t count)
+	{
+		std::size_t i = 0;
+
+#if defined(__SSE2__)
+		__m128 const scale = _mm_set1_ps(255.f);
+		__m128 const zero = _mm_setzero_ps();
+
+		auto convert = [&](vector4f const & c)
+		{
+			__m128 v = _mm_mul_ps(_mm_loadu_ps(&c.x), scale);
+			return _mm_cvttps_epi32(_mm_max_ps(_mm_min_ps(v, scale), zero));
+		};
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i lo = _mm_packs_epi32(convert(source[i + 0]), convert(source[i + 1]));
+			__m128i hi = _mm_packs_epi32(convert(source[i + 2]), convert(source[i + 3]));
+			_mm_storeu_si128((__m128i *)(destination + i), _mm_packus_epi16(lo, hi));
+		}
+#endif
+
+		for (; i < count; ++i)
+			destination[i] = to_color4ub(source[i]);
+	}
+
+	void convert(image_view<color4ub> const & source, image_view<vector4f> const & destination)
+	{
+		for_each_run(source, destination, [](color4ub const * source, vector4f * destination, std::size_t count){ to_vector4f(source, destination, count); });
+	}
+
+	void convert_srgb(image_view<color4ub> const & source, image_view<vector4f> const & destination)
+	{
+		for_each_run(source, destination, [](color4ub const * source, vector4f * destination, std::size_t count){ to_vector4f_srgb(source, destination, count); });
+	}
+
+	void convert(image_view<vector4f> const & source, image_view<color4ub> const & destination)
+	{
+		for_each_run(source, destination, [](vector4f const * source, color4ub * destination, std::size_t count){ to_color4ub(source, destination, count); });
+	}
+
+}
@@ -0,0 +1,71 @@
+#include <rasterizer/compressed_depth.hpp>
+
+namespace rasterizer
+{
+
+	namespace
+	{
+
+		// 16 KiB per chunk
+		constexpr std::uint32_t blocks_per_chunk = 64;
+
+		constexpr std::size_t block_size = tile_size * tile_size;
+
+	}
+
+	float * depth_pixel_pool::allocate()
+	{
+		if (chunks.empty() || used == blocks_per_chunk)
+		{
+			chunks.push_back(allocate_memory(blocks_per_chunk * block_size * sizeof(float), image_alignment, memory));
+			used = 0;
+		}
+
+		return (float *)chunks.back().get() + block_size * used++;
+	}
+
+	std::size_t depth_pixel_pool::memory_size() const
+	{
+		return chunks.size() * blocks_per_chunk * block_size * sizeof(float);
+	}
+
+	void decompress(compressed_depth_view const & view, depth_tile & tile, std::uint32_t x, std::uint32_t y)
+	{
+		if (tile.mode == depth_tile_mode::full)
+			return;
+
+		std::uint32_t const tx = x / tile_size * tile_size;
+		std::uint32_t const ty = y / tile_size * tile_size;
+
+		if (!tile.pixels)
+			tile.pixels = view.pool->allocate();
+
+		for (std::uint32_t i = 0; i < tile_size * tile_size; ++i)
+			tile.pixels[i] = view.load(tile, tx + i % tile_size, ty + i / tile_size);
+
+		// No pixel is known to hold the values of the next plane written yet
+		tile.mask = 0;
+		tile.mode = depth_tile_mode::full;
+	}
+
+	depth_tile_counts count_tile_modes(compressed_depth_view const & view)
+	{
+		depth_tile_counts result;
+
+		for (std::uint32_t y = 0; y < view.tiles.height; ++y)
+		{
+			for (std::uint32_t x = 0; x < view.tiles.width; ++x)
+			{
+				switch (view.tiles.at(x, y).mode)
+				{
+				case depth_tile_mode::one_plane: ++result.one_plane; break;
+				case depth_tile_mode::two_planes: ++result.two_planes; break;
+				case depth_tile_mode::full: ++result.full; break;
+				}
+			}
+		}
+
+		return result;
+	}
+
+}
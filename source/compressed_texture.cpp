@@ -0,0 +1,324 @@
+#include <rasterizer/compressed_texture.hpp>
+
+#include <cmath>
+#include <utility>
+
+namespace rasterizer
+{
+
+	namespace
+	{
+
+		std::uint16_t pack565(vector3f const & c)
+		{
+			auto quantize = [](float value, float range)
+			{
+				return (std::uint16_t)std::lround(max(0.f, min(range, value * range / 255.f)));
+			};
+
+			return (quantize(c.x, 31.f) << 11) | (quantize(c.y, 63.f) << 5) | quantize(c.z, 31.f);
+		}
+
+		color4ub unpack565(std::uint16_t c)
+		{
+			std::uint8_t r = (c >> 11) & 31;
+			std::uint8_t g = (c >> 5) & 63;
+			std::uint8_t b = c & 31;
+
+			return {(std::uint8_t)((r << 3) | (r >> 2)), (std::uint8_t)((g << 2) | (g >> 4)), (std::uint8_t)((b << 3) | (b >> 2)), 255};
+		}
+
+		color4ub mix(color4ub const & c0, color4ub const & c1, int w0, int w1)
+		{
+			int w = w0 + w1;
+
+			return
+			{
+				(std::uint8_t)((c0.r * w0 + c1.r * w1) / w),
+				(std::uint8_t)((c0.g * w0 + c1.g * w1) / w),
+				(std::uint8_t)((c0.b * w0 + c1.b * w1) / w),
+				255,
+			};
+		}
+
+		vector3f to_vector3f(color4ub const & c)
+		{
+			return {(float)c.r, (float)c.g, (float)c.b};
+		}
+
+		int distance2(color4ub const & c0, color4ub const & c1)
+		{
+			int dr = c0.r - c1.r;
+			int dg = c0.g - c1.g;
+			int db = c0.b - c1.b;
+			return dr * dr + dg * dg + db * db;
+		}
+
+		// Four-color mode is selected by color0 > color1, three-color mode
+		// (with index 3 meaning transparent black) by color0 <= color1
+		// BC3 color blocks are always decoded in four-color mode
+
+		void color_palette(bc1_block const & block, bool four_color, color4ub * palette)
+		{
+			palette[0] = unpack565(block.color0);
+			palette[1] = unpack565(block.color1);
+
+			if (four_color)
+			{
+				palette[2] = mix(palette[0], palette[1], 2, 1);
+				palette[3] = mix(palette[0], palette[1], 1, 2);
+			}
+			else
+			{
+				palette[2] = mix(palette[0], palette[1], 1, 1);
+				palette[3] = {0, 0, 0, 0};
+			}
+		}
+
+		bc1_block encode_color(color4ub const * texels, bool allow_transparent)
+		{
+			bool has_transparent = false;
+			if (allow_transparent)
+				for (int i = 0; i < 16; ++i)
+					has_transparent |= (texels[i].a < 128);
+
+			// Fit the endpoints to the principal axis of the block's colors
+
+			vector3f mean{0.f, 0.f, 0.f};
+			int opaque_count = 0;
+			for (int i = 0; i < 16; ++i)
+			{
+				if (has_transparent && texels[i].a < 128)
+					continue;
+				mean = mean + to_vector3f(texels[i]);
+				++opaque_count;
+			}
+
+			if (opaque_count == 0)
+				return bc1_block{.color0 = 0, .color1 = 0, .indices = 0xffffffffu};
+
+			mean = mean / opaque_count;
+
+			float covariance[6] = {0.f, 0.f, 0.f, 0.f, 0.f, 0.f};
+			for (int i = 0; i < 16; ++i)
+			{
+				if (has_transparent && texels[i].a < 128)
+					continue;
+
+				auto d = to_vector3f(texels[i]) - mean;
+				covariance[0] += d.x * d.x;
+				covariance[1] += d.x * d.y;
+				covariance[2] += d.x * d.z;
+				covariance[3] += d.y * d.y;
+				covariance[4] += d.y * d.z;
+				covariance[5] += d.z * d.z;
+			}
+
+			vector3f axis{1.f, 1.f, 1.f};
+			for (int iteration = 0; iteration < 4; ++iteration)
+			{
+				axis =
+				{
+					covariance[0] * axis.x + covariance[1] * axis.y + covariance[2] * axis.z,
+					covariance[1] * axis.x + covariance[3] * axis.y + covariance[4] * axis.z,
+					covariance[2] * axis.x + covariance[4] * axis.y + covariance[5] * axis.z,
+				};
+
+				float scale = max(std::abs(axis.x), max(std::abs(axis.y), std::abs(axis.z)));
+				if (scale == 0.f)
+					break;
+				axis = axis / scale;
+			}
+
+			vector3f endpoint0 = mean;
+			vector3f endpoint1 = mean;
+
+			if (float axis_length2 = dot(axis, axis); axis_length2 > 0.f)
+			{
+				float tmin = 0.f;
+				float tmax = 0.f;
+				for (int i = 0; i < 16; ++i)
+				{
+					if (has_transparent && texels[i].a < 128)
+						continue;
+
+					float t = dot(to_vector3f(texels[i]) - mean, axis) / axis_length2;
+					tmin = min(tmin, t);
+					tmax = max(tmax, t);
+				}
+
+				endpoint0 = mean + tmax * axis;
+				endpoint1 = mean + tmin * axis;
+			}
+
+			bc1_block block{.color0 = pack565(endpoint0), .color1 = pack565(endpoint1), .indices = 0};
+
+			if ((block.color0 < block.color1) != has_transparent)
+				std::swap(block.color0, block.color1);
+
+			bool four_color = block.color0 > block.color1;
+
+			color4ub palette[4];
+			color_palette(block, four_color, palette);
+
+			for (int i = 0; i < 16; ++i)
+			{
+				std::uint32_t index = 3;
+
+				if (!has_transparent || texels[i].a >= 128)
+				{
+					int best_distance = distance2(texels[i], palette[0]);
+					index = 0;
+
+					for (std::uint32_t j = 1; j < (four_color ? 4 : 3); ++j)
+					{
+						if (int distance = distance2(texels[i], palette[j]); distance < best_distance)
+						{
+							best_distance = distance;
+							index = j;
+						}
+					}
+				}
+
+				block.indices |= index << (2 * i);
+			}
+
+			return block;
+		}
+
+		void decode_color(bc1_block const & block, bool four_color, color4ub * texels)
+		{
+			color4ub palette[4];
+			color_palette(block, four_color, palette);
+
+			for (int i = 0; i < 16; ++i)
+				texels[i] = palette[(block.indices >> (2 * i)) & 3];
+		}
+
+		void alpha_palette(std::uint8_t alpha0, std::uint8_t alpha1, std::uint8_t * palette)
+		{
+			palette[0] = alpha0;
+			palette[1] = alpha1;
+
+			if (alpha0 > alpha1)
+			{
+				for (int i = 2; i < 8; ++i)
+					palette[i] = ((8 - i) * alpha0 + (i - 1) * alpha1) / 7;
+			}
+			else
+			{
+				for (int i = 2; i < 6; ++i)
+					palette[i] = ((6 - i) * alpha0 + (i - 1) * alpha1) / 5;
+				palette[6] = 0;
+				palette[7] = 255;
+			}
+		}
+
+		template <typename Block, typename Encode>
+		compressed_texture<Block> compress(texture<color4ub> const & texture, Encode && encode)
+		{
+			compressed_texture<Block> result;
+
+			for (auto const & mipmap : texture.mipmaps)
+			{
+				auto level = compressed_image<Block>::allocate(mipmap.width, mipmap.height);
+
+				for (std::uint32_t by = 0; by < level.height_in_blocks(); ++by)
+				{
+					for (std::uint32_t bx = 0; bx < level.width_in_blocks(); ++bx)
+					{
+						// Edge blocks of non-multiple-of-4 sizes replicate the last row & column
+
+						color4ub texels[16];
+						for (std::uint32_t y = 0; y < 4; ++y)
+							for (std::uint32_t x = 0; x < 4; ++x)
+								texels[x + 4 * y] = mipmap.at(min(4 * bx + x, mipmap.width - 1), min(4 * by + y, mipmap.height - 1));
+
+						level.blocks[bx + by * level.width_in_blocks()] = encode(texels);
+					}
+				}
+
+				result.mipmaps.push_back(std::move(level));
+			}
+
+			return result;
+		}
+
+	}
+
+	bc1_block encode_bc1(color4ub const * texels)
+	{
+		return encode_color(texels, true);
+	}
+
+	bc3_block encode_bc3(color4ub const * texels)
+	{
+		bc3_block block{.alpha0 = 0, .alpha1 = 255, .alpha_indices = {}, .color = encode_color(texels, false)};
+
+		for (int i = 0; i < 16; ++i)
+		{
+			block.alpha0 = max(block.alpha0, texels[i].a);
+			block.alpha1 = min(block.alpha1, texels[i].a);
+		}
+
+		std::uint8_t palette[8];
+		alpha_palette(block.alpha0, block.alpha1, palette);
+
+		std::uint64_t indices = 0;
+		for (int i = 0; i < 16; ++i)
+		{
+			std::uint64_t index = 0;
+
+			if (block.alpha0 != block.alpha1)
+			{
+				int best_distance = 256;
+				for (std::uint64_t j = 0; j < 8; ++j)
+				{
+					if (int distance = std::abs(texels[i].a - palette[j]); distance < best_distance)
+					{
+						best_distance = distance;
+						index = j;
+					}
+				}
+			}
+
+			indices |= index << (3 * i);
+		}
+
+		for (int i = 0; i < 6; ++i)
+			block.alpha_indices[i] = (indices >> (8 * i)) & 0xff;
+
+		return block;
+	}
+
+	void decode(bc1_block const & block, color4ub * texels)
+	{
+		decode_color(block, block.color0 > block.color1, texels);
+	}
+
+	void decode(bc3_block const & block, color4ub * texels)
+	{
+		decode_color(block.color, true, texels);
+
+		std::uint8_t palette[8];
+		alpha_palette(block.alpha0, block.alpha1, palette);
+
+		std::uint64_t indices = 0;
+		for (int i = 0; i < 6; ++i)
+			indices |= std::uint64_t(block.alpha_indices[i]) << (8 * i);
+
+		for (int i = 0; i < 16; ++i)
+			texels[i].a = palette[(indices >> (3 * i)) & 7];
+	}
+
+	compressed_texture<bc1_block> compress_bc1(texture<color4ub> const & texture)
+	{
+		return compress<bc1_block>(texture, encode_bc1);
+	}
+
+	compressed_texture<bc3_block> compress_bc3(texture<color4ub> const & texture)
+	{
+		return compress<bc3_block>(texture, encode_bc3);
+	}
+
+}
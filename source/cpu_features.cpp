@@ -0,0 +1,98 @@
+#include <rasterizer/cpu_features.hpp>
+
+#include <cstdint>
+#include <cstdlib>
+#include <string_view>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define RASTERIZER_HAS_CPUID 1
+#include <cpuid.h>
+#endif
+
+namespace rasterizer
+{
+
+	char const * const instruction_set_names[instruction_set_count] =
+	{
+		"baseline",
+		"avx2",
+		"avx512",
+	};
+
+	namespace
+	{
+
+#if defined(RASTERIZER_HAS_CPUID)
+		// Register state the OS saves on context switches, enabled in XCR0
+		std::uint64_t enabled_state()
+		{
+			std::uint32_t eax, edx;
+			__asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+			return eax | (std::uint64_t(edx) << 32);
+		}
+#endif
+
+	}
+
+	instruction_set detect_instruction_set()
+	{
+#if defined(RASTERIZER_HAS_CPUID)
+		unsigned int eax, ebx, ecx, edx;
+
+		if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+			return instruction_set::baseline;
+
+		bool const fma = ecx & (1u << 12);
+		bool const osxsave = ecx & (1u << 27);
+		bool const avx = ecx & (1u << 28);
+		bool const f16c = ecx & (1u << 29);
+
+		// The OS must save XMM & YMM registers, or AVX instructions fault
+		if (!osxsave || !avx || (enabled_state() & 0b110) != 0b110)
+			return instruction_set::baseline;
+
+		if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+			return instruction_set::baseline;
+
+		bool const bmi1 = ebx & (1u << 3);
+		bool const avx2 = ebx & (1u << 5);
+		bool const bmi2 = ebx & (1u << 8);
+
+		if (!(fma && f16c && bmi1 && avx2 && bmi2))
+			return instruction_set::baseline;
+
+		bool const avx512f = ebx & (1u << 16);
+		bool const avx512dq = ebx & (1u << 17);
+		bool const avx512bw = ebx & (1u << 30);
+		bool const avx512vl = ebx & (1u << 31);
+
+		// Plus opmask & upper ZMM registers
+		if (avx512f && avx512dq && avx512bw && avx512vl && (enabled_state() & 0b11100110) == 0b11100110)
+			return instruction_set::avx512;
+
+		return instruction_set::avx2;
+#else
+		return instruction_set::baseline;
+#endif
+	}
+
+	instruction_set active_instruction_set()
+	{
+		static instruction_set const result = []
+		{
+			auto detected = detect_instruction_set();
+
+			if (char const * requested = std::getenv("RASTERIZER_ISA"))
+			{
+				for (std::size_t i = 0; i < instruction_set_count; ++i)
+					if (requested == std::string_view(instruction_set_names[i]) && instruction_set(i) <= detected)
+						return instruction_set(i);
+			}
+
+			return detected;
+		}();
+
+		return result;
+	}
+
+}
@@ -0,0 +1,100 @@
+#include <rasterizer/heatmap.hpp>
+
+#include <algorithm>
+#include <iterator>
+
+namespace rasterizer
+{
+
+	heatmap_buffers heatmap_buffers::allocate(std::uint32_t width, std::uint32_t height)
+	{
+		image_view<std::uint32_t> size{.width = width, .height = height};
+
+		return heatmap_buffers
+		{
+			.depth_tests = image<std::uint32_t>::allocate(width, height),
+			.shaded = image<std::uint32_t>::allocate(width, height),
+			.writes = image<std::uint32_t>::allocate(width, height),
+			.tile_cost = image<std::uint32_t>::allocate(size.width_in_tiles(), size.height_in_tiles()),
+		};
+	}
+
+	void clear(heatmap_views const & heatmaps)
+	{
+		for (auto const & view : {heatmaps.depth_tests, heatmaps.shaded, heatmaps.writes, heatmaps.tile_cost})
+			if (view)
+				fill(view, std::uint32_t(0));
+	}
+
+	namespace
+	{
+
+		color4ub const ramp[] =
+		{
+			{  0,   0,   0, 255},
+			{  0,   0, 255, 255},
+			{  0, 255, 255, 255},
+			{  0, 255,   0, 255},
+			{255, 255,   0, 255},
+			{255,   0,   0, 255},
+			{255, 255, 255, 255},
+		};
+
+		constexpr std::uint32_t ramp_steps = std::size(ramp) - 1;
+
+		color4ub ramp_color(std::uint32_t value, std::uint32_t max_value)
+		{
+			if (value >= max_value)
+				return ramp[ramp_steps];
+
+			// 8-bit fixed point position along the ramp
+			std::uint32_t position = std::uint64_t(value) * ramp_steps * 256 / max_value;
+			std::uint32_t step = position / 256;
+			std::uint32_t t = position % 256;
+
+			auto const & a = ramp[step];
+			auto const & b = ramp[step + 1];
+
+			return color4ub
+			{
+				std::uint8_t((a.r * (256 - t) + b.r * t) / 256),
+				std::uint8_t((a.g * (256 - t) + b.g * t) / 256),
+				std::uint8_t((a.b * (256 - t) + b.b * t) / 256),
+				255,
+			};
+		}
+
+	}
+
+	void false_color(image_view<std::uint32_t> const & values, image_view<color4ub> const & result, std::uint32_t max_value)
+	{
+		if (!values || !result)
+			return;
+
+		if (max_value == 0)
+		{
+			for (std::uint32_t y = 0; y < values.height; ++y)
+				for (std::uint32_t x = 0; x < values.width; ++x)
+					max_value = std::max(max_value, values.at(x, y));
+
+			// All zero, everything maps to black
+			max_value = std::max(max_value, 1u);
+		}
+
+		// A value per tile of the result maps onto its pixels the way draws bin them, which
+		// scaling doesn't when the size isn't a multiple of the tile size
+		bool per_tile = values.width == result.width_in_tiles() && values.height == result.height_in_tiles();
+
+		for (std::uint32_t y = 0; y < result.height; ++y)
+		{
+			std::uint32_t source_y = per_tile ? y / tile_size : std::uint64_t(y) * values.height / result.height;
+
+			for (std::uint32_t x = 0; x < result.width; ++x)
+			{
+				std::uint32_t source_x = per_tile ? x / tile_size : std::uint64_t(x) * values.width / result.width;
+				result.at(x, y) = ramp_color(values.at(source_x, source_y), max_value);
+			}
+		}
+	}
+
+}
@@ -1,17 +1,150 @@
 #include <rasterizer/image.hpp>
 
+#include "image_runs.hpp"
+
 #define STB_IMAGE_IMPLEMENTATION
 #include <rasterizer/stb_image.h>
 
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace rasterizer
 {
 
+	namespace
+	{
+
+		image<color4ub> adopt_stbi_pixels(stbi_uc * pixels, int width, int height)
+		{
+			if (!pixels)
+				return {};
+
+			return image<color4ub>
+			{
+				.pixels = std::shared_ptr<color4ub[]>((color4ub *)pixels, [](color4ub * pixels){ stbi_image_free(pixels); }),
+				.width = (std::uint32_t)width,
+				.height = (std::uint32_t)height,
+			};
+		}
+
+		void copy_run(color4ub const * source, color4ub * destination, std::size_t count)
+		{
+#if defined(__SSE2__)
+			if (count == tile_size)
+			{
+				static_assert(tile_size * sizeof(color4ub) == 2 * sizeof(__m128i));
+
+				__m128i p0 = _mm_loadu_si128((__m128i const *)(source + 0));
+				__m128i p1 = _mm_loadu_si128((__m128i const *)(source + 4));
+				_mm_storeu_si128((__m128i *)(destination + 0), p0);
+				_mm_storeu_si128((__m128i *)(destination + 4), p1);
+				return;
+			}
+#endif
+
+			std::memcpy(destination, source, count * sizeof(color4ub));
+		}
+
+		void copy_run_swap_red_blue(color4ub const * source, color4ub * destination, std::size_t count)
+		{
+#if defined(__SSE2__)
+			__m128i const green_alpha_mask = _mm_set1_epi32(0xff00ff00);
+
+			for (; count >= 4; count -= 4, source += 4, destination += 4)
+			{
+				__m128i pixels = _mm_loadu_si128((__m128i const *)source);
+				__m128i red_blue = _mm_andnot_si128(green_alpha_mask, pixels);
+				__m128i green_alpha = _mm_and_si128(green_alpha_mask, pixels);
+
+				// Within each 32-bit pixel, red moves up to byte 2 and blue down to byte 0
+				red_blue = _mm_or_si128(_mm_slli_epi32(red_blue, 16), _mm_srli_epi32(red_blue, 16));
+
+				_mm_storeu_si128((__m128i *)destination, _mm_or_si128(red_blue, green_alpha));
+			}
+#endif
+
+			for (; count > 0; --count, ++source, ++destination)
+				*destination = {source->b, source->g, source->r, source->a};
+		}
+
+	}
+
+	void copy(image_view<color4ub> const & source, image_view<color4ub> const & destination)
+	{
+		for_each_run(source, destination, copy_run);
+	}
+
+	void copy(image_view<color4ub> const & source, image_view<color4ub> const & destination, channel_order destination_order)
+	{
+		if (destination_order == channel_order::rgba)
+			for_each_run(source, destination, copy_run);
+		else
+			for_each_run(source, destination, copy_run_swap_red_blue);
+	}
+
 	image<color4ub> load_image(std::filesystem::path const & path)
 	{
-		image<color4ub> result;
-		int channels;
-		result.pixels.reset((color4ub *)stbi_load(path.c_str(), (int *)&result.width, (int *)&result.height, &channels, 4));
-		return result;
+		int width, height, channels;
+		auto pixels = stbi_load(path.c_str(), &width, &height, &channels, 4);
+		return adopt_stbi_pixels(pixels, width, height);
+	}
+
+	image<color4ub> load_image(std::span<std::uint8_t const> data)
+	{
+		int width, height, channels;
+		auto pixels = stbi_load_from_memory(data.data(), data.size(), &width, &height, &channels, 4);
+		return adopt_stbi_pixels(pixels, width, height);
+	}
+
+	bool save_image(std::filesystem::path const & path, image_view<color4ub> const & image)
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return false;
+
+		bool const tga = path.extension() == ".tga";
+
+		if (tga)
+		{
+			// Uncompressed true-color, 32 bits per pixel with 8 alpha bits, top-left origin
+			std::uint8_t header[18] = {0, 0, 2};
+			header[12] = image.width & 0xff;
+			header[13] = image.width >> 8;
+			header[14] = image.height & 0xff;
+			header[15] = image.height >> 8;
+			header[16] = 32;
+			header[17] = 0x28;
+			file.write((char const *)header, sizeof(header));
+		}
+		else
+			file << "P6\n" << image.width << " " << image.height << "\n255\n";
+
+		std::vector<std::uint8_t> row;
+
+		for (std::uint32_t y = 0; y < image.height; ++y)
+		{
+			row.clear();
+
+			for (std::uint32_t x = 0; x < image.width; ++x)
+			{
+				auto const & pixel = image.at(x, y);
+
+				if (tga)
+					row.insert(row.end(), {pixel.b, pixel.g, pixel.r, pixel.a});
+				else
+					row.insert(row.end(), {pixel.r, pixel.g, pixel.b});
+			}
+
+			file.write((char const *)row.data(), row.size());
+		}
+
+		return bool(file);
 	}
 
 }
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <rasterizer/image_view.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+namespace rasterizer
+{
+
+	// Calls run(source, destination, count) for runs of pixels that are contiguous in both
+	// views, whatever their layouts: rows when both are linear, else rows of tiles, which
+	// are also contiguous in linear rows
+	template <typename Source, typename Destination, typename Run>
+	void for_each_run(image_view<Source> const & source, image_view<Destination> const & destination, Run && run)
+	{
+		assert(source.width == destination.width && source.height == destination.height);
+
+		if (source.layout == image_layout::linear && destination.layout == image_layout::linear)
+		{
+			for (std::uint32_t y = 0; y < source.height; ++y)
+				run(&source.at(0, y), &destination.at(0, y), source.width);
+			return;
+		}
+
+		for (std::uint32_t y = 0; y < source.height; ++y)
+			for (std::uint32_t x = 0; x < source.width; x += tile_size)
+				run(&source.at(x, y), &destination.at(x, y), std::min(tile_size, source.width - x));
+	}
+
+}
@@ -0,0 +1,28 @@
+#include "kernels.hpp"
+
+namespace rasterizer
+{
+
+	kernels const & active_kernels()
+	{
+		static kernels const & result = []() -> kernels const &
+		{
+#if defined(__x86_64__) || defined(__i386__)
+			switch (active_instruction_set())
+			{
+			case instruction_set::avx512:
+				return avx512::kernel_table;
+			case instruction_set::avx2:
+				return avx2::kernel_table;
+			case instruction_set::baseline:
+				break;
+			}
+#endif
+
+			return baseline::kernel_table;
+		}();
+
+		return result;
+	}
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <rasterizer/renderer.hpp>
+#include <rasterizer/pipeline.hpp>
+#include <rasterizer/shader.hpp>
+#include <rasterizer/texture.hpp>
+#include <rasterizer/cpu_features.hpp>
+#include <rasterizer/depth_format.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// The renderer's hot loops (kernels.inl) are compiled once per instruction set by the
+// kernels_<isa>.cpp files, each into a namespace of its own, and called through the table
+// of the instruction set picked at runtime
+//
+// Every header is included here, before kernels_<isa>.cpp enables its instruction set, so that
+// inline functions from headers are still compiled for the baseline: the linker keeps one of
+// their copies for the whole program, which must run on every CPU. They get inlined into the
+// kernels and compiled for the kernel's instruction set there
+
+// Intrinsics a kernel can use explicitly, beyond what the compiler generates
+#define RASTERIZER_ISA_LEVEL_NONE 0
+#define RASTERIZER_ISA_LEVEL_SSE2 1
+#define RASTERIZER_ISA_LEVEL_AVX2 2
+#define RASTERIZER_ISA_LEVEL_AVX512 3
+
+// Kernels inline every function from the headers they call: a call out of them would land in
+// the copy compiled for the baseline, and switching between SSE and AVX encodings around
+// every such call costs more than the wider instructions save
+#if defined(__GNUC__)
+#define RASTERIZER_KERNEL __attribute__((flatten))
+#else
+#define RASTERIZER_KERNEL
+#endif
+
+namespace rasterizer
+{
+
+	struct kernels
+	{
+		void (*clear_color)(image_view<color4ub> const &, vector4f const &);
+		void (*clear_depth32)(image_view<std::uint32_t> const &, std::uint32_t);
+		void (*clear_depth16)(image_view<std::uint16_t> const &, std::uint16_t);
+		void (*clear_depth24)(image_view<depth24> const &, std::uint32_t);
+		void (*clear_depth_float)(image_view<float> const &, float);
+		void (*clear_compressed_depth)(compressed_depth_view const &, float);
+
+		vertex * (*clip_triangle)(vertex * begin, vertex * end);
+
+		// No tracing, capture or counters, draw() takes care of those
+		void (*draw)(framebuffer const &, viewport const &, draw_command const &, render_stats *);
+
+		// Box-filters rows [ybegin, yend) of the next mipmap level
+		void (*downsample_rows)(image<color4ub> const & prev_level, image<color4ub> & next_level, std::uint32_t ybegin, std::uint32_t yend);
+	};
+
+	namespace baseline { extern kernels const kernel_table; }
+	namespace avx2 { extern kernels const kernel_table; }
+	namespace avx512 { extern kernels const kernel_table; }
+
+	// Kernels of active_instruction_set()
+	kernels const & active_kernels();
+
+}
@@ -0,0 +1,375 @@
+// Hot loops of the renderer, compiled once per instruction set: included by every kernels_<isa>.cpp
+// with RASTERIZER_ISA naming the instruction set's namespace, and RASTERIZER_ISA_LEVEL telling
+// which intrinsics are available (see kernels.hpp)
+
+namespace rasterizer::RASTERIZER_ISA
+{
+
+	RASTERIZER_KERNEL vertex * clip_triangle(vertex * begin, vertex * end)
+	{
+		return clip_near_far(begin, end);
+	}
+
+	RASTERIZER_KERNEL void clear(image_view<color4ub> const & color_buffer, vector4f const & color)
+	{
+		fill(color_buffer, to_color4ub(color));
+	}
+
+	RASTERIZER_KERNEL void clear(image_view<std::uint32_t> const & depth_buffer, std::uint32_t value)
+	{
+		fill(depth_buffer, value);
+	}
+
+	RASTERIZER_KERNEL void clear(image_view<std::uint16_t> const & depth_buffer, std::uint16_t value)
+	{
+		fill(depth_buffer, value);
+	}
+
+	RASTERIZER_KERNEL void clear(image_view<depth24> const & depth_buffer, std::uint32_t value)
+	{
+		// Copy a pattern of whole pixels instead of storing 3 bytes at a time
+		depth24 pattern[tile_size * tile_size];
+		for (auto & pixel : pattern)
+			depth_format<depth24>::store(pixel, value);
+
+		for_each_run(depth_buffer, [&pattern](depth24 * run, std::size_t count)
+		{
+			for (std::size_t i = 0; i < count; i += std::size(pattern))
+				std::memcpy(run + i, pattern, std::min(count - i, std::size(pattern)) * sizeof(depth24));
+		});
+	}
+
+	RASTERIZER_KERNEL void clear(image_view<float> const & depth_buffer, float value)
+	{
+		fill(depth_buffer, value);
+	}
+
+	// Keeps the tiles' per-pixel storage for the next frame
+	RASTERIZER_KERNEL void clear(compressed_depth_view const & depth_buffer, float depth)
+	{
+		for (std::uint32_t y = 0; y < depth_buffer.tiles.height; ++y)
+		{
+			for (std::uint32_t x = 0; x < depth_buffer.tiles.width; ++x)
+			{
+				depth_tile & tile = depth_buffer.tiles.at(x, y);
+				tile.planes[0] = {.c = depth};
+				tile.mode = depth_tile_mode::one_plane;
+			}
+		}
+	}
+
+	namespace
+	{
+
+		// One element of an attribute in Format: decode_attribute, except that kernels with F16C
+		// convert half floats in hardware, the header can only use what every CPU has
+		template <typename T, attribute_format Format>
+		T decode_element(char const * element)
+		{
+#if RASTERIZER_ISA_LEVEL >= RASTERIZER_ISA_LEVEL_AVX2
+			if constexpr (Format == attribute_format::float16)
+			{
+				float values[4];
+				_mm_storeu_ps(values, _mm_cvtph_ps(detail::load_low<attribute_size<T>(Format)>(element)));
+
+				T result;
+				std::memcpy(&result, values, sizeof(T));
+				return result;
+			}
+#endif
+
+			return decode_attribute<T, Format>(element);
+		}
+
+		// Attributes read in a format resolved once per draw, so that the decoder is inlined into
+		// the vertex shader
+		template <typename T, attribute_format Format>
+		struct attribute_in_format
+		{
+			char const * pointer;
+			std::uint32_t stride;
+
+			explicit attribute_in_format(attribute<T> const & attribute)
+				: pointer((char const *)(attribute.pointer))
+				, stride(attribute.stride)
+			{}
+
+			T operator[](std::uint32_t index) const
+			{
+				return decode_element<T, Format>(pointer + stride * index);
+			}
+		};
+
+		// Attributes in formats without a variant of their own, switching over the format per element
+		template <typename T>
+		struct attribute_in_any_format
+		{
+			rasterizer::attribute<T> attribute;
+
+			T operator[](std::uint32_t index) const
+			{
+				char const * element = (char const *)(attribute.pointer) + attribute.stride * index;
+
+				return visit_format<T>(attribute.format, [element]<attribute_format Format>(std::integral_constant<attribute_format, Format>)
+				{
+					return decode_element<T, Format>(element);
+				});
+			}
+		};
+
+		// draw_command's fixed-function shading, as shaders for rasterize()
+
+		struct fixed_function_varyings
+		{
+			vector3f world_position;
+			vector3f normal;
+			vector4f color;
+			vector2f texcoord;
+		};
+
+		template <typename Positions, typename Normals, typename Colors, typename Texcoords>
+		struct fixed_function_vertex_shader
+		{
+			draw_command const & command;
+			matrix4x4f view_projection = command.projection * command.view;
+
+			Positions positions{command.mesh.positions};
+			Normals normals{command.mesh.normals};
+			Colors colors{command.mesh.colors};
+			Texcoords texcoords{command.mesh.texcoords};
+
+			shaded_vertex<fixed_function_varyings> operator()(std::uint32_t index) const
+			{
+				auto world_position = to_vector3f(command.model * as_point(positions[index]));
+
+				return
+				{
+					.position = view_projection * as_point(world_position),
+					.varyings = {
+						.world_position = world_position,
+						.normal = to_vector3f(command.model * as_vector(normals[index])),
+						.color = colors[index],
+						.texcoord = texcoords[index],
+					},
+				};
+			}
+		};
+
+		template <attribute_format Positions, attribute_format Normals, attribute_format Colors, attribute_format Texcoords>
+		using vertex_shader_for = fixed_function_vertex_shader<attribute_in_format<vector3f, Positions>, attribute_in_format<vector3f, Normals>, attribute_in_format<vector4f, Colors>, attribute_in_format<vector2f, Texcoords>>;
+
+		using any_format_vertex_shader = fixed_function_vertex_shader<attribute_in_any_format<vector3f>, attribute_in_any_format<vector3f>, attribute_in_any_format<vector4f>, attribute_in_any_format<vector2f>>;
+
+		// Texture is null when the command has no albedo texture
+		template <typename Texture>
+		struct fixed_function_fragment_shader
+		{
+			draw_command const & command;
+			Texture const * texture;
+			mutable texel_fetcher<Texture> fetch = {};
+
+			vector4f operator()(fragment<fixed_function_varyings> const & pixel) const
+			{
+				auto color = pixel.varying(&fixed_function_varyings::color);
+
+				if (texture)
+				{
+					vector2f texcoord[2][2];
+					pixel.quad(&fixed_function_varyings::texcoord, texcoord);
+
+					color = sample(*texture, command.albedo->sampler, fetch, texcoord, pixel.dx, pixel.dy);
+				}
+
+				if (command.lights)
+				{
+					auto lighting = compute_lighting(*command.lights, pixel.varying(&fixed_function_varyings::world_position), normalized(pixel.varying(&fixed_function_varyings::normal)));
+
+					auto result = lighting * to_vector3f(color);
+
+					color = {result.x, result.y, result.z, color.w};
+				}
+
+				return color;
+			}
+		};
+
+		// depth_buffer is the framebuffer's depth buffer, resolved to its type
+
+		template <bool Instrumented, typename VertexShader, typename Texture, typename DepthView>
+		RASTERIZER_KERNEL void draw_with_texture(framebuffer const & framebuffer, DepthView const & depth_buffer, viewport const & viewport, draw_command const & command, Texture const * texture, render_stats * stats)
+		{
+			shader_command<VertexShader, fixed_function_fragment_shader<Texture>> const shaders
+			{
+				.vertex_shader = {.command = command},
+				.fragment_shader = {.command = command, .texture = texture},
+				.indices = command.mesh.indices,
+				.count = command.mesh.count,
+				.cull_mode = command.cull_mode,
+				.depth = command.depth,
+			};
+
+			rasterize<Instrumented>(framebuffer, depth_buffer, viewport, shaders, stats);
+		}
+
+	}
+
+	void draw(framebuffer const & framebuffer, viewport const & viewport, draw_command const & command, render_stats * stats)
+	{
+		// Resolve the depth format, texture type, vertex formats & whether to collect stats or heatmaps
+		// once per draw, not per pixel or vertex
+		auto resolve_and_draw = [&]<bool Instrumented>(std::bool_constant<Instrumented>)
+		{
+			auto draw_with_vertex_shader = [&]<typename VertexShader>(std::type_identity<VertexShader>)
+			{
+				std::visit([&](auto const & depth_buffer)
+				{
+					if (!command.albedo)
+						return draw_with_texture<Instrumented, VertexShader, texture<color4ub>>(framebuffer, depth_buffer, viewport, command, nullptr, stats);
+
+					std::visit([&](auto const * texture){ draw_with_texture<Instrumented, VertexShader>(framebuffer, depth_buffer, viewport, command, texture, stats); }, command.albedo->texture);
+				}, framebuffer.depth);
+			};
+
+			// Vertex formats have variants for float meshes and packed_mesh_data only, others are
+			// switched over per vertex, as are all of them in instrumented draws, which would
+			// otherwise double the variants for the sake of debugging
+			if constexpr (!Instrumented)
+			{
+				using enum attribute_format;
+				auto const & mesh = command.mesh;
+
+				if (mesh.positions.format == float32 && mesh.normals.format == float32 && mesh.colors.format == float32 && mesh.texcoords.format == float32)
+					return draw_with_vertex_shader(std::type_identity<vertex_shader_for<float32, float32, float32, float32>>{});
+
+				if (mesh.positions.format == float16 && mesh.normals.format == octahedral_snorm16 && mesh.colors.format == float32 && mesh.texcoords.format == float16)
+					return draw_with_vertex_shader(std::type_identity<vertex_shader_for<float16, octahedral_snorm16, float32, float16>>{});
+			}
+
+			draw_with_vertex_shader(std::type_identity<any_format_vertex_shader>{});
+		};
+
+		if (stats || framebuffer.heatmaps)
+			resolve_and_draw(std::true_type{});
+		else
+			resolve_and_draw(std::false_type{});
+	}
+
+	namespace
+	{
+
+		// Every channel is the exact integer average of a 2x2 footprint, rounded down
+		// like the float-to-color4ub conversion does, coordinates past the edge of
+		// odd-sized levels are clamped
+
+		color4ub box_filter(image<color4ub> const & prev_level, std::uint32_t x, std::uint32_t y)
+		{
+			std::uint32_t x0 = min(2 * x + 0, prev_level.width - 1);
+			std::uint32_t x1 = min(2 * x + 1, prev_level.width - 1);
+			std::uint32_t y0 = min(2 * y + 0, prev_level.height - 1);
+			std::uint32_t y1 = min(2 * y + 1, prev_level.height - 1);
+
+			auto const & p00 = prev_level.at(x0, y0);
+			auto const & p10 = prev_level.at(x1, y0);
+			auto const & p01 = prev_level.at(x0, y1);
+			auto const & p11 = prev_level.at(x1, y1);
+
+			return
+			{
+				(std::uint8_t)((p00.r + p10.r + p01.r + p11.r) >> 2),
+				(std::uint8_t)((p00.g + p10.g + p01.g + p11.g) >> 2),
+				(std::uint8_t)((p00.b + p10.b + p01.b + p11.b) >> 2),
+				(std::uint8_t)((p00.a + p10.a + p01.a + p11.a) >> 2),
+			};
+		}
+
+	}
+
+	RASTERIZER_KERNEL void downsample_rows(image<color4ub> const & prev_level, image<color4ub> & next_level, std::uint32_t ybegin, std::uint32_t yend)
+	{
+		for (std::uint32_t y = ybegin; y < yend; ++y)
+		{
+			std::uint32_t x = 0;
+
+#if RASTERIZER_ISA_LEVEL >= RASTERIZER_ISA_LEVEL_SSE2
+			if (2 * y + 1 < prev_level.height)
+			{
+				auto row0 = &prev_level.at(0, 2 * y + 0);
+				auto row1 = &prev_level.at(0, 2 * y + 1);
+				auto out = &next_level.at(0, y);
+
+#if RASTERIZER_ISA_LEVEL >= RASTERIZER_ISA_LEVEL_AVX2
+				// Same as below on both 128-bit lanes at once, 8 output pixels per iteration;
+				// the lanes hold output pixels 0, 1, 4, 5 and 2, 3, 6, 7, put back in order when storing
+				__m256i const zero256 = _mm256_setzero_si256();
+
+				for (; 2 * x + 16 <= prev_level.width; x += 8)
+				{
+					__m256i a0 = _mm256_loadu_si256((__m256i const *)(row0 + 2 * x + 0));
+					__m256i a1 = _mm256_loadu_si256((__m256i const *)(row0 + 2 * x + 8));
+					__m256i b0 = _mm256_loadu_si256((__m256i const *)(row1 + 2 * x + 0));
+					__m256i b1 = _mm256_loadu_si256((__m256i const *)(row1 + 2 * x + 8));
+
+					__m256i v0 = _mm256_add_epi16(_mm256_unpacklo_epi8(a0, zero256), _mm256_unpacklo_epi8(b0, zero256));
+					__m256i v1 = _mm256_add_epi16(_mm256_unpackhi_epi8(a0, zero256), _mm256_unpackhi_epi8(b0, zero256));
+					__m256i v2 = _mm256_add_epi16(_mm256_unpacklo_epi8(a1, zero256), _mm256_unpacklo_epi8(b1, zero256));
+					__m256i v3 = _mm256_add_epi16(_mm256_unpackhi_epi8(a1, zero256), _mm256_unpackhi_epi8(b1, zero256));
+
+					__m256i h0 = _mm256_add_epi16(_mm256_unpacklo_epi64(v0, v1), _mm256_unpackhi_epi64(v0, v1));
+					__m256i h1 = _mm256_add_epi16(_mm256_unpacklo_epi64(v2, v3), _mm256_unpackhi_epi64(v2, v3));
+
+					h0 = _mm256_srli_epi16(h0, 2);
+					h1 = _mm256_srli_epi16(h1, 2);
+
+					__m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(h0, h1), _MM_SHUFFLE(3, 1, 2, 0));
+
+					_mm256_storeu_si256((__m256i *)(out + x), packed);
+				}
+#endif
+
+				// 4 output pixels per iteration, from two full rows of 8 input pixels
+				__m128i const zero = _mm_setzero_si128();
+
+				for (; 2 * x + 8 <= prev_level.width; x += 4)
+				{
+					__m128i a0 = _mm_loadu_si128((__m128i const *)(row0 + 2 * x + 0));
+					__m128i a1 = _mm_loadu_si128((__m128i const *)(row0 + 2 * x + 4));
+					__m128i b0 = _mm_loadu_si128((__m128i const *)(row1 + 2 * x + 0));
+					__m128i b1 = _mm_loadu_si128((__m128i const *)(row1 + 2 * x + 4));
+
+					// Vertical sums, two input pixels per register
+					__m128i v0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+					__m128i v1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+					__m128i v2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+					__m128i v3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+					// Horizontal sums of neighbouring pixels
+					__m128i h0 = _mm_add_epi16(_mm_unpacklo_epi64(v0, v1), _mm_unpackhi_epi64(v0, v1));
+					__m128i h1 = _mm_add_epi16(_mm_unpacklo_epi64(v2, v3), _mm_unpackhi_epi64(v2, v3));
+
+					h0 = _mm_srli_epi16(h0, 2);
+					h1 = _mm_srli_epi16(h1, 2);
+
+					_mm_storeu_si128((__m128i *)(out + x), _mm_packus_epi16(h0, h1));
+				}
+			}
+#endif
+
+			for (; x < next_level.width; ++x)
+				next_level.at(x, y) = box_filter(prev_level, x, y);
+		}
+	}
+
+	extern kernels const kernel_table
+	{
+		.clear_color = clear,
+		.clear_depth32 = clear,
+		.clear_depth16 = clear,
+		.clear_depth24 = clear,
+		.clear_depth_float = clear,
+		.clear_compressed_depth = clear,
+		.clip_triangle = RASTERIZER_ISA::clip_triangle,
+		.draw = draw,
+		.downsample_rows = downsample_rows,
+	};
+
+}
@@ -0,0 +1,23 @@
+#include "kernels.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#define RASTERIZER_ISA avx512
+#define RASTERIZER_ISA_LEVEL RASTERIZER_ISA_LEVEL_AVX512
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f,avx512bw,avx512dq,avx512vl,avx2,fma,bmi,bmi2,f16c"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw,avx512dq,avx512vl,avx2,fma,bmi,bmi2,f16c")
+#endif
+
+#include "kernels.inl"
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif
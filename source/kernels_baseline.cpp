@@ -0,0 +1,13 @@
+#include "kernels.hpp"
+
+// Whatever the compiler targets by default
+
+#define RASTERIZER_ISA baseline
+
+#if defined(__SSE2__)
+#define RASTERIZER_ISA_LEVEL RASTERIZER_ISA_LEVEL_SSE2
+#else
+#define RASTERIZER_ISA_LEVEL RASTERIZER_ISA_LEVEL_NONE
+#endif
+
+#include "kernels.inl"
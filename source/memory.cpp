@@ -0,0 +1,77 @@
+#include <rasterizer/memory.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace rasterizer
+{
+
+	namespace
+	{
+
+		void touch_pages(void * pointer, std::size_t size)
+		{
+			// Writing (rather than reading) makes sure private pages are actually allocated
+			volatile std::uint8_t * bytes = (std::uint8_t *)pointer;
+			for (std::size_t offset = 0; offset < size; offset += 4096)
+				bytes[offset] = 0;
+		}
+
+#if defined(__linux__)
+		std::shared_ptr<void> map_pages(std::size_t size, int flags)
+		{
+			void * pointer = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+			if (pointer == MAP_FAILED)
+				return nullptr;
+
+			return std::shared_ptr<void>(pointer, [size](void * pointer){ ::munmap(pointer, size); });
+		}
+#endif
+
+	}
+
+	std::shared_ptr<void> allocate_memory(std::size_t size, std::size_t alignment, memory_options const & options)
+	{
+#if defined(__linux__)
+		if (options.huge_pages && size >= huge_page_size / 2)
+		{
+			std::size_t rounded_size = (size + huge_page_size - 1) / huge_page_size * huge_page_size;
+			int populate = options.prefault ? MAP_POPULATE : 0;
+
+			// Explicit huge pages need a reserved pool (vm.nr_hugepages), often not configured
+			if (auto result = map_pages(rounded_size, MAP_HUGETLB | populate))
+				return result;
+
+			// Transparent huge pages: over-allocate so that the start can be aligned to a huge page,
+			// which is what lets the kernel back the range with huge pages
+			std::size_t mapped_size = rounded_size + huge_page_size;
+			if (auto mapping = map_pages(mapped_size, 0))
+			{
+				auto aligned = (std::uint8_t *)(((std::uintptr_t)mapping.get() + huge_page_size - 1) / huge_page_size * huge_page_size);
+
+				::madvise(aligned, rounded_size, MADV_HUGEPAGE);
+
+				if (options.prefault)
+					touch_pages(aligned, rounded_size);
+
+				return std::shared_ptr<void>(mapping, aligned);
+			}
+		}
+#endif
+
+		void * pointer = ::operator new(size, std::align_val_t(alignment));
+		std::shared_ptr<void> result(pointer, [alignment](void * pointer){ ::operator delete(pointer, std::align_val_t(alignment)); });
+
+		if (options.prefault)
+			touch_pages(pointer, size);
+
+		return result;
+	}
+
+}
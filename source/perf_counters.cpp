@@ -0,0 +1,138 @@
+#include <rasterizer/perf_counters.hpp>
+
+#include <atomic>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace rasterizer
+{
+
+	namespace
+	{
+
+		std::atomic<bool> enabled{false};
+
+#if defined(__linux__)
+
+		struct counter_config
+		{
+			std::uint32_t type;
+			std::uint64_t config;
+		};
+
+		counter_config const configs[perf_counter_count] =
+		{
+			{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+			{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+			{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+			{PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+			{PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+		};
+
+		// Counters of one thread, opened as a group so that a single read returns all of them
+		struct thread_counters
+		{
+			int leader = -1;
+			int fds[perf_counter_count];
+
+			// Counters that opened, in the order the group read returns them
+			std::uint32_t available = 0;
+
+			thread_counters()
+			{
+				for (std::size_t i = 0; i < perf_counter_count; ++i)
+				{
+					perf_event_attr attr{};
+					attr.size = sizeof(attr);
+					attr.type = configs[i].type;
+					attr.config = configs[i].config;
+					attr.exclude_kernel = 1;
+					attr.exclude_hv = 1;
+					attr.read_format = PERF_FORMAT_GROUP;
+
+					fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+
+					if (fds[i] < 0)
+						continue;
+
+					if (leader < 0)
+						leader = fds[i];
+
+					available |= 1u << i;
+				}
+			}
+
+			~thread_counters()
+			{
+				for (int fd : fds)
+					if (fd >= 0)
+						close(fd);
+			}
+
+			perf_values read() const
+			{
+				perf_values result;
+
+				if (leader < 0)
+					return result;
+
+				// Number of counters, then their values
+				std::uint64_t data[1 + perf_counter_count];
+
+				if (::read(leader, data, sizeof(data)) < ssize_t(sizeof(std::uint64_t)))
+					return result;
+
+				std::uint64_t index = 0;
+				for (std::size_t i = 0; i < perf_counter_count && index < data[0]; ++i)
+				{
+					if (available & (1u << i))
+						result.values[i] = data[1 + index++];
+				}
+
+				result.available = available;
+				return result;
+			}
+		};
+
+		thread_counters const & current_thread_counters()
+		{
+			thread_local thread_counters counters;
+			return counters;
+		}
+
+#endif
+
+	}
+
+	bool enable_perf_counters(bool enable)
+	{
+#if defined(__linux__)
+		if (enable && current_thread_counters().available == 0)
+			enable = false;
+#else
+		enable = false;
+#endif
+
+		enabled.store(enable, std::memory_order_relaxed);
+		return enable;
+	}
+
+	bool perf_counters_enabled()
+	{
+		return enabled.load(std::memory_order_relaxed);
+	}
+
+	perf_values read_perf_counters()
+	{
+#if defined(__linux__)
+		if (perf_counters_enabled())
+			return current_thread_counters().read();
+#endif
+		return {};
+	}
+
+}
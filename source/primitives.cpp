@@ -0,0 +1,138 @@
+#include <rasterizer/primitives.hpp>
+
+#include <cmath>
+
+namespace rasterizer
+{
+
+	mesh mesh_data::view() const
+	{
+		return mesh
+		{
+			.positions = {positions.data()},
+			.normals = {normals.data()},
+			.colors = {&mesh::default_color, 0},
+			.texcoords = {texcoords.data()},
+			.indices = indices.data(),
+			.count = (std::uint32_t)indices.size(),
+		};
+	}
+
+	mesh packed_mesh_data::view() const
+	{
+		return mesh
+		{
+			.positions = {positions.data(), attribute_size<vector3f>(attribute_format::float16), attribute_format::float16},
+			.normals = {normals.data(), attribute_size<vector3f>(attribute_format::octahedral_snorm16), attribute_format::octahedral_snorm16},
+			.colors = {&mesh::default_color, 0},
+			.texcoords = {texcoords.data(), attribute_size<vector2f>(attribute_format::float16), attribute_format::float16},
+			.indices = indices.data(),
+			.count = (std::uint32_t)indices.size(),
+		};
+	}
+
+	packed_mesh_data pack(mesh_data const & data)
+	{
+		packed_mesh_data result;
+		result.indices = data.indices;
+
+		result.positions.reserve(data.positions.size() * 3);
+		for (auto const & position : data.positions)
+			for (float value : {position.x, position.y, position.z})
+				result.positions.push_back(float_to_half(value));
+
+		result.normals.reserve(data.normals.size() * 2);
+		for (auto const & normal : data.normals)
+			for (auto value : encode_octahedral_snorm16(normal))
+				result.normals.push_back(value);
+
+		result.texcoords.reserve(data.texcoords.size() * 2);
+		for (auto const & texcoord : data.texcoords)
+			for (float value : {texcoord.x, texcoord.y})
+				result.texcoords.push_back(float_to_half(value));
+
+		return result;
+	}
+
+	namespace
+	{
+
+		// Indices of a (columns + 1) x (rows + 1) vertex lattice, counter-clockwise
+		// when the lattice goes right along columns and up along rows
+		void lattice_indices(std::uint32_t columns, std::uint32_t rows, std::vector<std::uint32_t> & indices)
+		{
+			indices.reserve(columns * rows * 6);
+
+			for (std::uint32_t y = 0; y < rows; ++y)
+			{
+				for (std::uint32_t x = 0; x < columns; ++x)
+				{
+					std::uint32_t i00 = y * (columns + 1) + x;
+					std::uint32_t i10 = i00 + 1;
+					std::uint32_t i01 = i00 + columns + 1;
+					std::uint32_t i11 = i01 + 1;
+
+					indices.insert(indices.end(), {i00, i10, i01, i01, i10, i11});
+				}
+			}
+		}
+
+	}
+
+	mesh_data make_sphere(std::uint32_t rings, std::uint32_t segments)
+	{
+		mesh_data result;
+
+		result.positions.reserve((rings + 1) * (segments + 1));
+		result.normals.reserve((rings + 1) * (segments + 1));
+		result.texcoords.reserve((rings + 1) * (segments + 1));
+
+		// The seam and the poles duplicate vertices so that texcoords don't wrap
+		for (std::uint32_t r = 0; r <= rings; ++r)
+		{
+			float v = r * 1.f / rings;
+			float theta = (v - 0.5f) * M_PIf;
+
+			for (std::uint32_t s = 0; s <= segments; ++s)
+			{
+				float u = s * 1.f / segments;
+				float phi = u * 2.f * M_PIf;
+
+				vector3f normal{std::cos(theta) * std::sin(phi), std::sin(theta), std::cos(theta) * std::cos(phi)};
+
+				result.positions.push_back(normal);
+				result.normals.push_back(normal);
+				result.texcoords.push_back({u, v});
+			}
+		}
+
+		lattice_indices(segments, rings, result.indices);
+
+		return result;
+	}
+
+	mesh_data make_plane(std::uint32_t cells)
+	{
+		mesh_data result;
+
+		result.positions.reserve((cells + 1) * (cells + 1));
+		result.normals.assign((cells + 1) * (cells + 1), {0.f, 0.f, 1.f});
+		result.texcoords.reserve((cells + 1) * (cells + 1));
+
+		for (std::uint32_t y = 0; y <= cells; ++y)
+		{
+			for (std::uint32_t x = 0; x <= cells; ++x)
+			{
+				vector2f texcoord{x * 1.f / cells, y * 1.f / cells};
+
+				result.positions.push_back({2.f * texcoord.x - 1.f, 2.f * texcoord.y - 1.f, 0.f});
+				result.texcoords.push_back(texcoord);
+			}
+		}
+
+		lattice_indices(cells, cells, result.indices);
+
+		return result;
+	}
+
+}
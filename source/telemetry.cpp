@@ -0,0 +1,319 @@
+#include <rasterizer/telemetry.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+namespace rasterizer
+{
+
+	void time_series::add(float milliseconds)
+	{
+		history[count % history_size] = milliseconds;
+		++count;
+		total += milliseconds;
+		max = std::max(max, milliseconds);
+
+		float position = 4.f * std::log2(std::max(milliseconds, 1e-6f) * 16.f);
+		auto bucket = (std::uint32_t)std::clamp(position, 0.f, float(bucket_count - 1));
+		++buckets[bucket];
+	}
+
+	float time_series::bucket_upper_bound(std::uint32_t bucket)
+	{
+		return std::exp2((bucket + 1) / 4.f) / 16.f;
+	}
+
+	time_summary time_series::rolling() const
+	{
+		time_summary result;
+
+		std::uint32_t size = std::min<std::uint64_t>(count, history_size);
+		if (size == 0)
+			return result;
+
+		float sorted[history_size];
+		std::copy(history, history + size, sorted);
+		std::sort(sorted, sorted + size);
+
+		float sum = 0.f;
+		for (std::uint32_t i = 0; i < size; ++i)
+			sum += sorted[i];
+
+		// Nearest rank
+		auto percentile = [&](float p){ return sorted[std::clamp<std::uint32_t>(std::ceil(p * size), 1, size) - 1]; };
+
+		result.p50 = percentile(0.50f);
+		result.p99 = percentile(0.99f);
+		result.max = sorted[size - 1];
+		result.mean = sum / size;
+		result.samples = size;
+
+		return result;
+	}
+
+	time_summary time_series::overall() const
+	{
+		time_summary result;
+
+		if (count == 0)
+			return result;
+
+		auto percentile = [&](double p)
+		{
+			std::uint64_t rank = std::max<std::uint64_t>(1, std::ceil(p * count));
+			std::uint64_t seen = 0;
+
+			for (std::uint32_t bucket = 0; bucket < bucket_count; ++bucket)
+			{
+				seen += buckets[bucket];
+				if (seen >= rank)
+					return bucket_upper_bound(bucket);
+			}
+
+			return bucket_upper_bound(bucket_count - 1);
+		};
+
+		result.p50 = percentile(0.50);
+		result.p99 = percentile(0.99);
+		result.max = max;
+		result.mean = total / count;
+		result.samples = count;
+
+		return result;
+	}
+
+	std::size_t telemetry::add_series(char const * name)
+	{
+		series.push_back({.name = name});
+		return series.size() - 1;
+	}
+
+	namespace
+	{
+
+		// 3x5 pixel glyphs, one row per 3 bits, top row first
+		std::uint16_t glyph(char c)
+		{
+			if (c >= 'a' && c <= 'z')
+				c = c - 'a' + 'A';
+
+			static std::uint16_t const digits[10] =
+			{
+				0b111'101'101'101'111,
+				0b010'110'010'010'111,
+				0b111'001'111'100'111,
+				0b111'001'111'001'111,
+				0b101'101'111'001'001,
+				0b111'100'111'001'111,
+				0b111'100'111'101'111,
+				0b111'001'001'010'010,
+				0b111'101'111'101'111,
+				0b111'101'111'001'111,
+			};
+
+			static std::uint16_t const letters[26] =
+			{
+				0b010'101'111'101'101, // A
+				0b110'101'110'101'110, // B
+				0b011'100'100'100'011, // C
+				0b110'101'101'101'110, // D
+				0b111'100'110'100'111, // E
+				0b111'100'110'100'100, // F
+				0b011'100'101'101'011, // G
+				0b101'101'111'101'101, // H
+				0b111'010'010'010'111, // I
+				0b001'001'001'101'010, // J
+				0b101'101'110'101'101, // K
+				0b100'100'100'100'111, // L
+				0b101'111'111'101'101, // M
+				0b110'101'101'101'101, // N
+				0b010'101'101'101'010, // O
+				0b110'101'110'100'100, // P
+				0b010'101'101'110'011, // Q
+				0b110'101'110'101'101, // R
+				0b011'100'010'001'110, // S
+				0b111'010'010'010'010, // T
+				0b101'101'101'101'111, // U
+				0b101'101'101'101'010, // V
+				0b101'101'111'111'101, // W
+				0b101'101'010'101'101, // X
+				0b101'101'010'010'010, // Y
+				0b111'001'010'100'111, // Z
+			};
+
+			if (c >= '0' && c <= '9')
+				return digits[c - '0'];
+			if (c >= 'A' && c <= 'Z')
+				return letters[c - 'A'];
+
+			switch (c)
+			{
+			case '.': return 0b000'000'000'000'010;
+			case ':': return 0b000'010'000'010'000;
+			case '%': return 0b101'001'010'100'101;
+			case '/': return 0b001'001'010'100'100;
+			case '-': return 0b000'000'111'000'000;
+			}
+
+			return 0;
+		}
+
+		constexpr std::uint32_t glyph_scale = 2;
+		constexpr std::uint32_t glyph_advance = 4 * glyph_scale;
+		constexpr std::uint32_t line_height = 7 * glyph_scale;
+
+		void draw_text(image_view<color4ub> const & target, std::uint32_t x, std::uint32_t y, char const * text, color4ub color)
+		{
+			for (; *text; ++text, x += glyph_advance)
+			{
+				auto bits = glyph(*text);
+
+				for (std::uint32_t gy = 0; gy < 5 * glyph_scale; ++gy)
+				{
+					for (std::uint32_t gx = 0; gx < 3 * glyph_scale; ++gx)
+					{
+						std::uint32_t bit = 14 - (gy / glyph_scale) * 3 - (gx / glyph_scale);
+
+						if (((bits >> bit) & 1) && x + gx < target.width && y + gy < target.height)
+							target.at(x + gx, y + gy) = color;
+					}
+				}
+			}
+		}
+
+		// Halves the brightness, so that text stays readable over anything
+		void darken(image_view<color4ub> const & target, std::uint32_t width, std::uint32_t height)
+		{
+			for (std::uint32_t y = 0; y < std::min(height, target.height); ++y)
+			{
+				for (std::uint32_t x = 0; x < std::min(width, target.width); ++x)
+				{
+					auto & pixel = target.at(x, y);
+					pixel = {std::uint8_t(pixel.r / 2), std::uint8_t(pixel.g / 2), std::uint8_t(pixel.b / 2), pixel.a};
+				}
+			}
+		}
+
+		void append_summary(std::string & out, time_summary const & summary)
+		{
+			char buffer[160];
+			std::snprintf(buffer, sizeof(buffer), "{\"samples\":%llu,\"mean\":%.3f,\"p50\":%.3f,\"p99\":%.3f,\"max\":%.3f}",
+				(unsigned long long)summary.samples, summary.mean, summary.p50, summary.p99, summary.max);
+			out += buffer;
+		}
+
+	}
+
+	void draw_overlay(telemetry const & telemetry, image_view<color4ub> const & target)
+	{
+		if (!target || telemetry.series.empty())
+			return;
+
+		constexpr std::uint32_t margin = 4;
+		constexpr std::uint32_t graph_height = 48;
+		constexpr std::uint32_t panel_width = 2 * margin + std::max(40 * glyph_advance, time_series::history_size);
+
+		std::uint32_t panel_height = 2 * margin + telemetry.series.size() * line_height + graph_height;
+
+		darken(target, panel_width, panel_height);
+
+		std::uint32_t y = margin;
+
+		for (auto const & series : telemetry.series)
+		{
+			auto summary = series.rolling();
+
+			char line[64];
+			std::snprintf(line, sizeof(line), "%-7.7s P50 %6.1f P99 %6.1f MAX %6.1f", series.name, summary.p50, summary.p99, summary.max);
+			draw_text(target, margin, y, line, {255, 255, 255, 255});
+
+			y += line_height;
+		}
+
+		// Oldest sample on the left, one pixel per sample
+		auto const & frames = telemetry.series.front();
+
+		float const budget = 1000.f / 60.f;
+		float scale = std::max(2.f * budget, frames.rolling().max);
+
+		std::uint32_t graph_bottom = y + graph_height - 1;
+		std::uint32_t size = std::min<std::uint64_t>(frames.count, time_series::history_size);
+
+		for (std::uint32_t i = 0; i < size; ++i)
+		{
+			float value = frames.history[(frames.count - size + i) % time_series::history_size];
+			std::uint32_t height = std::min<float>(graph_height, std::ceil(value / scale * graph_height));
+			std::uint32_t x = margin + i;
+
+			color4ub color = value > budget ? color4ub{255, 64, 64, 255} : color4ub{64, 255, 64, 255};
+
+			for (std::uint32_t h = 0; h < height; ++h)
+				if (x < target.width && graph_bottom - h < target.height)
+					target.at(x, graph_bottom - h) = color;
+		}
+
+		std::uint32_t budget_y = graph_bottom - std::uint32_t(budget / scale * graph_height);
+		for (std::uint32_t x = margin; x < margin + time_series::history_size; ++x)
+			if (x < target.width && budget_y < target.height)
+				target.at(x, budget_y) = {255, 255, 0, 255};
+	}
+
+	telemetry_exporter::telemetry_exporter(std::filesystem::path const & path, std::chrono::duration<float> interval)
+		: interval(std::chrono::duration_cast<clock::duration>(interval))
+		, start(clock::now())
+		, next_export(start + this->interval)
+	{
+		writer = std::thread([this, path]
+		{
+			std::ofstream file(path, std::ios::app);
+
+			while (auto line = lines.pop())
+			{
+				file << *line << '\n';
+				file.flush();
+			}
+		});
+	}
+
+	telemetry_exporter::~telemetry_exporter()
+	{
+		lines.close();
+		writer.join();
+	}
+
+	void telemetry_exporter::update(telemetry const & telemetry)
+	{
+		auto now = clock::now();
+
+		if (now < next_export)
+			return;
+
+		next_export = now + interval;
+
+		std::string line;
+
+		char buffer[64];
+		std::snprintf(buffer, sizeof(buffer), "{\"time\":%.3f,\"series\":{", std::chrono::duration<double>(now - start).count());
+		line += buffer;
+
+		for (std::size_t i = 0; i < telemetry.series.size(); ++i)
+		{
+			auto const & series = telemetry.series[i];
+
+			line += i == 0 ? "\"" : ",\"";
+			line += series.name;
+			line += "\":{\"rolling\":";
+			append_summary(line, series.rolling());
+			line += ",\"overall\":";
+			append_summary(line, series.overall());
+			line += "}";
+		}
+
+		line += "}}";
+
+		lines.try_push(std::move(line));
+	}
+
+}
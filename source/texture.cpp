@@ -1,15 +1,38 @@
 #include <rasterizer/texture.hpp>
+#include <rasterizer/thread_pool.hpp>
+#include <rasterizer/trace.hpp>
+
+#include "kernels.hpp"
 
 namespace rasterizer
 {
 
-	void generate_mipmaps(texture<color4ub> & texture)
+	namespace
+	{
+
+		// Levels smaller than this are not worth splitting across threads
+		constexpr std::uint32_t parallel_rows_threshold = 64;
+
+	}
+
+	void generate_mipmaps(texture<color4ub> & texture, thread_pool * pool, memory_options const & memory)
 	{
+		RASTERIZER_TRACE_ZONE("generate mipmaps");
+
 		if (texture.mipmaps.empty())
 			return;
 
+		// Only the calling thread is counted, not the pool's workers
+		bool const measure_perf = trace::enabled && perf_counters_enabled();
+		perf_values perf_begin;
+
+		if (measure_perf)
+			perf_begin = read_perf_counters();
+
 		texture.mipmaps.resize(1);
 
+		auto const & kernels = active_kernels();
+
 		for (int i = 1;; ++i)
 		{
 			auto & prev_level = texture.mipmaps[i - 1];
@@ -20,32 +43,27 @@ namespace rasterizer
 			std::uint32_t new_width = prev_level.width / 2 + (prev_level.width & 1);
 			std::uint32_t new_height = prev_level.height / 2 + (prev_level.height & 1);
 
-			image<color4ub> next_level = image<color4ub>::allocate(new_width, new_height);
+			image<color4ub> next_level = image<color4ub>::allocate(new_width, new_height, {.memory = memory});
 
-			auto get_pixel = [&](std::uint32_t x, std::uint32_t y)
-			{
-				return to_vector4f(prev_level.at(std::min(x, prev_level.width - 1), std::min(y, prev_level.height - 1)));
-			};
-
-			for (std::uint32_t y = 0; y < new_height; ++y)
-			{
-				for (std::uint32_t x = 0; x < new_width; ++x)
-				{
-					vector4f result{0.f, 0.f, 0.f, 0.f};
-
-					result = result + get_pixel(2 * x + 0, 2 * y + 0);
-					result = result + get_pixel(2 * x + 1, 2 * y + 0);
-					result = result + get_pixel(2 * x + 0, 2 * y + 1);
-					result = result + get_pixel(2 * x + 1, 2 * y + 1);
-
-					result = result / 4.f;
-
-					next_level.at(x, y) = to_color4ub(result);
-				}
-			}
+			if (pool && new_height >= parallel_rows_threshold)
+				pool->parallel_for(new_height, [&](std::uint32_t begin, std::uint32_t end){ kernels.downsample_rows(prev_level, next_level, begin, end); });
+			else
+				kernels.downsample_rows(prev_level, next_level, 0, new_height);
 
 			texture.mipmaps.push_back(std::move(next_level));
 		}
+
+		if (measure_perf)
+			trace::record_counters("generate mipmaps", trace::now(), read_perf_counters() - perf_begin);
+	}
+
+	void generate_mipmaps(std::span<texture<color4ub>> textures, thread_pool & pool, memory_options const & memory)
+	{
+		pool.parallel_for(textures.size(), [&](std::uint32_t begin, std::uint32_t end)
+		{
+			for (std::uint32_t i = begin; i < end; ++i)
+				generate_mipmaps(textures[i], nullptr, memory);
+		});
 	}
 
 }
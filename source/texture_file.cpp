@@ -0,0 +1,313 @@
+#include <rasterizer/texture_file.hpp>
+#include <rasterizer/image.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if __has_include(<sys/mman.h>)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define RASTERIZER_HAS_MMAP 1
+#else
+#define RASTERIZER_HAS_MMAP 0
+#endif
+
+namespace rasterizer
+{
+
+	namespace
+	{
+
+		template <typename Texture>
+		struct texture_file_traits;
+
+		template <>
+		struct texture_file_traits<texture<color4ub>>
+		{
+			using element_type = color4ub;
+
+			static constexpr texture_file_format format = texture_file_format::rgba8;
+
+			static std::uint64_t element_count(std::uint32_t width, std::uint32_t height)
+			{
+				return std::uint64_t(width) * height;
+			}
+
+			static void write(std::ostream & file, image<color4ub> const & level)
+			{
+				for (std::uint32_t y = 0; y < level.height; ++y)
+					file.write((char const *)&level.at(0, y), level.width * sizeof(element_type));
+			}
+
+			static image<color4ub> make_level(std::shared_ptr<element_type[]> data, std::uint32_t width, std::uint32_t height)
+			{
+				return {.pixels = std::move(data), .width = width, .height = height};
+			}
+		};
+
+		template <typename Block, texture_file_format Format>
+		struct compressed_texture_file_traits
+		{
+			using element_type = Block;
+
+			static constexpr texture_file_format format = Format;
+
+			static std::uint64_t element_count(std::uint32_t width, std::uint32_t height)
+			{
+				return std::uint64_t((width + 3) / 4) * ((height + 3) / 4);
+			}
+
+			static void write(std::ostream & file, compressed_image<Block> const & level)
+			{
+				file.write((char const *)level.blocks.get(), element_count(level.width, level.height) * sizeof(element_type));
+			}
+
+			static compressed_image<Block> make_level(std::shared_ptr<element_type[]> data, std::uint32_t width, std::uint32_t height)
+			{
+				return {.blocks = std::move(data), .width = width, .height = height};
+			}
+		};
+
+		template <>
+		struct texture_file_traits<compressed_texture<bc1_block>>
+			: compressed_texture_file_traits<bc1_block, texture_file_format::bc1>
+		{};
+
+		template <>
+		struct texture_file_traits<compressed_texture<bc3_block>>
+			: compressed_texture_file_traits<bc3_block, texture_file_format::bc3>
+		{};
+
+		std::uint64_t align_up(std::uint64_t value)
+		{
+			return (value + texture_file_alignment - 1) / texture_file_alignment * texture_file_alignment;
+		}
+
+		// Keeps the whole file alive, levels alias into it
+		struct mapped_file
+		{
+			std::shared_ptr<std::uint8_t[]> data;
+			std::uint64_t size = 0;
+		};
+
+		mapped_file map_file(std::filesystem::path const & path)
+		{
+#if RASTERIZER_HAS_MMAP
+			int fd = ::open(path.c_str(), O_RDONLY);
+			if (fd < 0)
+				return {};
+
+			struct stat info;
+			if (::fstat(fd, &info) != 0 || info.st_size == 0)
+			{
+				::close(fd);
+				return {};
+			}
+
+			std::uint64_t size = info.st_size;
+
+			// Private writable mapping: reads are zero-copy, writes are copy-on-write
+			// and never reach the file
+			void * pointer = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+			::close(fd);
+
+			if (pointer == MAP_FAILED)
+				return {};
+
+			return mapped_file
+			{
+				.data = std::shared_ptr<std::uint8_t[]>((std::uint8_t *)pointer, [size](std::uint8_t * pointer){ ::munmap(pointer, size); }),
+				.size = size,
+			};
+#else
+			std::ifstream file(path, std::ios::binary | std::ios::ate);
+			if (!file)
+				return {};
+
+			std::uint64_t size = file.tellg();
+			file.seekg(0);
+
+			std::shared_ptr<std::uint8_t[]> data(new std::uint8_t[size]);
+			if (!file.read((char *)data.get(), size))
+				return {};
+
+			return mapped_file{.data = std::move(data), .size = size};
+#endif
+		}
+
+		template <typename Texture>
+		Texture map_texture(std::filesystem::path const & path, std::uint64_t const * expected_source_hash)
+		{
+			using traits = texture_file_traits<Texture>;
+			using element_type = typename traits::element_type;
+
+			auto file = map_file(path);
+
+			if (file.size < sizeof(texture_file_header))
+				return {};
+
+			texture_file_header header;
+			std::memcpy(&header, file.data.get(), sizeof(header));
+
+			if (std::memcmp(header.magic, texture_file_header{}.magic, sizeof(header.magic)) != 0)
+				return {};
+
+			if (header.version != texture_file_header{}.version || header.format != traits::format)
+				return {};
+
+			if (expected_source_hash && header.source_hash != *expected_source_hash)
+				return {};
+
+			if (file.size < sizeof(header) + std::uint64_t(header.level_count) * sizeof(texture_file_level))
+				return {};
+
+			Texture result;
+
+			for (std::uint32_t i = 0; i < header.level_count; ++i)
+			{
+				texture_file_level level;
+				std::memcpy(&level, file.data.get() + sizeof(header) + i * sizeof(level), sizeof(level));
+
+				bool valid = level.size == traits::element_count(level.width, level.height) * sizeof(element_type)
+					&& level.offset % texture_file_alignment == 0
+					&& level.offset <= file.size
+					&& level.size <= file.size - level.offset;
+
+				if (!valid)
+					return {};
+
+				auto data = std::shared_ptr<element_type[]>(file.data, (element_type *)(file.data.get() + level.offset));
+				result.mipmaps.push_back(traits::make_level(std::move(data), level.width, level.height));
+			}
+
+			return result;
+		}
+
+		std::uint64_t content_hash(std::span<std::uint8_t const> data)
+		{
+			// 64-bit FNV-1a
+			std::uint64_t hash = 0xcbf29ce484222325ull;
+			for (auto byte : data)
+			{
+				hash ^= byte;
+				hash *= 0x100000001b3ull;
+			}
+			return hash;
+		}
+
+		std::vector<std::uint8_t> read_file(std::filesystem::path const & path)
+		{
+			std::ifstream file(path, std::ios::binary | std::ios::ate);
+			if (!file)
+				return {};
+
+			std::vector<std::uint8_t> result(file.tellg());
+			file.seekg(0);
+			if (!file.read((char *)result.data(), result.size()))
+				return {};
+
+			return result;
+		}
+
+	}
+
+	template <typename Texture>
+	bool save_texture(std::filesystem::path const & path, Texture const & texture, std::uint64_t source_hash)
+	{
+		using traits = texture_file_traits<Texture>;
+		using element_type = typename traits::element_type;
+
+		texture_file_header header
+		{
+			.format = traits::format,
+			.level_count = (std::uint32_t)texture.mipmaps.size(),
+			.source_hash = source_hash,
+		};
+
+		std::vector<texture_file_level> levels;
+
+		std::uint64_t offset = align_up(sizeof(header) + texture.mipmaps.size() * sizeof(texture_file_level));
+		for (auto const & mipmap : texture.mipmaps)
+		{
+			std::uint64_t size = traits::element_count(mipmap.width, mipmap.height) * sizeof(element_type);
+			levels.push_back({.offset = offset, .size = size, .width = mipmap.width, .height = mipmap.height});
+			offset = align_up(offset + size);
+		}
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return false;
+
+		file.write((char const *)&header, sizeof(header));
+		file.write((char const *)levels.data(), levels.size() * sizeof(levels[0]));
+
+		char const padding[texture_file_alignment] = {};
+
+		for (std::size_t i = 0; i < levels.size(); ++i)
+		{
+			file.write(padding, levels[i].offset - file.tellp());
+			traits::write(file, texture.mipmaps[i]);
+		}
+
+		return bool(file);
+	}
+
+	template <typename Texture>
+	Texture map_texture(std::filesystem::path const & path)
+	{
+		return map_texture<Texture>(path, nullptr);
+	}
+
+	texture<color4ub> load_texture_cached(std::filesystem::path const & path, std::filesystem::path const & cache_directory, thread_pool * pool)
+	{
+		auto data = read_file(path);
+		if (data.empty())
+			return {};
+
+		std::uint64_t hash = content_hash(data);
+
+		char name[32];
+		std::snprintf(name, sizeof(name), "%016llx.rtex", (unsigned long long)hash);
+		auto cache_path = cache_directory / name;
+
+		if (auto result = map_texture<texture<color4ub>>(cache_path, &hash); !result.mipmaps.empty())
+			return result;
+
+		texture<color4ub> result;
+		result.mipmaps.push_back(load_image(data));
+		if (!result.mipmaps[0])
+			return {};
+
+		generate_mipmaps(result, pool);
+
+		// Write to a temporary file first so that concurrent loads never map a partial file
+		std::error_code error;
+		std::filesystem::create_directories(cache_directory, error);
+
+		auto temporary_path = cache_path;
+		temporary_path += ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+		if (save_texture(temporary_path, result, hash))
+			std::filesystem::rename(temporary_path, cache_path, error);
+		else
+			std::filesystem::remove(temporary_path, error);
+
+		return result;
+	}
+
+	template bool save_texture(std::filesystem::path const &, texture<color4ub> const &, std::uint64_t);
+	template bool save_texture(std::filesystem::path const &, compressed_texture<bc1_block> const &, std::uint64_t);
+	template bool save_texture(std::filesystem::path const &, compressed_texture<bc3_block> const &, std::uint64_t);
+
+	template texture<color4ub> map_texture(std::filesystem::path const &);
+	template compressed_texture<bc1_block> map_texture(std::filesystem::path const &);
+	template compressed_texture<bc3_block> map_texture(std::filesystem::path const &);
+
+}
@@ -0,0 +1,57 @@
+#include <rasterizer/texture_loader.hpp>
+#include <rasterizer/texture_file.hpp>
+
+namespace rasterizer
+{
+
+	texture_handle load_texture_async(std::filesystem::path const & path, thread_pool & pool, texture_load_options const & options)
+	{
+		return texture_handle
+		{
+			.future = pool.submit([path, options]
+			{
+				if (options.cache_directory)
+					return load_texture_cached(path, *options.cache_directory);
+
+				texture<color4ub> result;
+
+				if (auto image = load_image(path))
+				{
+					result.mipmaps.push_back(std::move(image));
+
+					if (options.generate_mipmaps)
+						generate_mipmaps(result);
+				}
+
+				return result;
+			}).share(),
+		};
+	}
+
+	std::vector<texture_handle> load_textures_async(std::span<std::filesystem::path const> paths, thread_pool & pool, texture_load_options const & options)
+	{
+		std::vector<texture_handle> result;
+		result.reserve(paths.size());
+
+		for (auto const & path : paths)
+			result.push_back(load_texture_async(path, pool, options));
+
+		return result;
+	}
+
+	texture<color4ub> make_checkerboard_texture(color4ub color0, color4ub color1)
+	{
+		texture<color4ub> result;
+
+		result.mipmaps.push_back(image<color4ub>::allocate(2, 2));
+		result.mipmaps[0].at(0, 0) = color0;
+		result.mipmaps[0].at(1, 0) = color1;
+		result.mipmaps[0].at(0, 1) = color1;
+		result.mipmaps[0].at(1, 1) = color0;
+
+		generate_mipmaps(result);
+
+		return result;
+	}
+
+}
@@ -0,0 +1,116 @@
+#include <rasterizer/thread_pool.hpp>
+#include <rasterizer/trace.hpp>
+
+#include <algorithm>
+#include <atomic>
+
+namespace rasterizer
+{
+
+	thread_pool::thread_pool(std::uint32_t thread_count)
+	{
+		for (std::uint32_t i = 0; i < thread_count; ++i)
+		{
+			threads.emplace_back([this]
+			{
+				if constexpr (trace::enabled)
+					trace::set_thread_name("worker");
+
+				while (true)
+				{
+					std::function<void()> task;
+
+					{
+						std::unique_lock lock{mutex};
+						condition.wait(lock, [this]{ return stopping || !tasks.empty(); });
+
+						if (tasks.empty())
+							return;
+
+						task = std::move(tasks.front());
+						tasks.pop_front();
+					}
+
+					RASTERIZER_TRACE_ZONE("task");
+					task();
+				}
+			});
+		}
+	}
+
+	thread_pool::~thread_pool()
+	{
+		{
+			std::lock_guard lock{mutex};
+			stopping = true;
+		}
+
+		condition.notify_all();
+
+		for (auto & thread : threads)
+			thread.join();
+	}
+
+	void thread_pool::push(std::function<void()> task)
+	{
+		{
+			std::lock_guard lock{mutex};
+			tasks.push_back(std::move(task));
+		}
+
+		condition.notify_one();
+	}
+
+	void thread_pool::parallel_for(std::uint32_t count, std::function<void(std::uint32_t begin, std::uint32_t end)> const & function)
+	{
+		std::uint32_t chunk_count = std::min<std::uint32_t>(count, 4 * (thread_count() + 1));
+
+		if (chunk_count <= 1 || threads.empty())
+		{
+			if (count > 0)
+				function(0, count);
+			return;
+		}
+
+		struct state
+		{
+			std::atomic<std::uint32_t> next_chunk{0};
+			std::uint32_t done_chunks = 0;
+			std::mutex mutex;
+			std::condition_variable condition;
+		};
+
+		// Helpers may start after this call returned, so they only share the state
+		// and never touch the function unless they claim a chunk
+
+		auto shared_state = std::make_shared<state>();
+
+		auto run_chunks = [shared_state, &function, count, chunk_count]
+		{
+			std::uint32_t processed = 0;
+
+			for (std::uint32_t chunk; (chunk = shared_state->next_chunk++) < chunk_count; ++processed)
+			{
+				RASTERIZER_TRACE_ZONE("parallel_for chunk");
+				function(std::uint64_t(count) * chunk / chunk_count, std::uint64_t(count) * (chunk + 1) / chunk_count);
+			}
+
+			if (processed > 0)
+			{
+				std::lock_guard lock{shared_state->mutex};
+				shared_state->done_chunks += processed;
+				shared_state->condition.notify_all();
+			}
+		};
+
+		std::uint32_t helper_count = std::min<std::uint32_t>(thread_count(), chunk_count - 1);
+		for (std::uint32_t i = 0; i < helper_count; ++i)
+			push(run_chunks);
+
+		run_chunks();
+
+		std::unique_lock lock{shared_state->mutex};
+		shared_state->condition.wait(lock, [&]{ return shared_state->done_chunks == chunk_count; });
+	}
+
+}
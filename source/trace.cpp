@@ -0,0 +1,237 @@
+#include <rasterizer/trace.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace rasterizer::trace
+{
+
+	namespace
+	{
+
+		// Single-writer ring of Ts, stored as atomic words so that a concurrent dump reads
+		// them without a data race; the head tells which slots were overwritten meanwhile
+		template <typename T, std::uint32_t Capacity>
+		struct ring
+		{
+			static_assert(std::is_trivially_copyable_v<T> && sizeof(T) % sizeof(std::uint64_t) == 0);
+
+			static constexpr std::size_t words_per_entry = sizeof(T) / sizeof(std::uint64_t);
+
+			std::atomic<std::uint64_t> head{0};
+			std::unique_ptr<std::atomic<std::uint64_t>[]> words{new std::atomic<std::uint64_t>[Capacity * words_per_entry]};
+
+			void push(T const & value)
+			{
+				std::uint64_t value_words[words_per_entry];
+				std::memcpy(value_words, &value, sizeof(T));
+
+				auto index = head.load(std::memory_order_relaxed);
+				auto slot = words.get() + (index % Capacity) * words_per_entry;
+
+				for (std::size_t i = 0; i < words_per_entry; ++i)
+					slot[i].store(value_words[i], std::memory_order_relaxed);
+
+				head.store(index + 1, std::memory_order_release);
+			}
+
+			// Entries still held, oldest first
+			std::vector<T> read() const
+			{
+				auto end = head.load(std::memory_order_acquire);
+				auto begin = end > Capacity ? end - Capacity : 0;
+
+				std::vector<T> result(end - begin);
+
+				for (auto index = begin; index < end; ++index)
+				{
+					std::uint64_t value_words[words_per_entry];
+					auto slot = words.get() + (index % Capacity) * words_per_entry;
+
+					for (std::size_t i = 0; i < words_per_entry; ++i)
+						value_words[i] = slot[i].load(std::memory_order_relaxed);
+
+					std::memcpy(&result[index - begin], value_words, sizeof(T));
+				}
+
+				// Entries the writer overwrote while they were being copied are dropped,
+				// including the one it may be writing right now
+				std::atomic_thread_fence(std::memory_order_acquire);
+				auto new_end = head.load(std::memory_order_relaxed);
+				auto valid_begin = new_end + 1 > Capacity ? new_end + 1 - Capacity : 0;
+
+				if (valid_begin > begin)
+					result.erase(result.begin(), result.begin() + std::min(valid_begin - begin, end - begin));
+
+				return result;
+			}
+		};
+
+		struct event
+		{
+			char const * name;
+			std::uint64_t begin;
+			std::uint64_t end;
+		};
+
+		struct counter_sample
+		{
+			char const * name;
+			std::uint64_t time;
+			perf_values values;
+		};
+
+		struct thread_buffer
+		{
+			std::uint32_t id;
+			std::atomic<char const *> name{nullptr};
+			ring<event, ring_capacity> events;
+			ring<counter_sample, counter_ring_capacity> counters;
+		};
+
+		// Buffers outlive their threads so that their events still make it to the dump
+		struct registry
+		{
+			std::mutex mutex;
+			std::vector<std::unique_ptr<thread_buffer>> buffers;
+		};
+
+		registry & global_registry()
+		{
+			static registry instance;
+			return instance;
+		}
+
+		thread_buffer & current_buffer()
+		{
+			thread_local thread_buffer * buffer = nullptr;
+
+			if (!buffer)
+			{
+				auto & registry = global_registry();
+				std::lock_guard lock{registry.mutex};
+				buffer = registry.buffers.emplace_back(std::make_unique<thread_buffer>()).get();
+				buffer->id = registry.buffers.size();
+			}
+
+			return *buffer;
+		}
+
+		void write_string(std::ostream & out, char const * string)
+		{
+			out << '"';
+			for (; *string; ++string)
+			{
+				if (*string == '"' || *string == '\\')
+					out << '\\';
+				out << *string;
+			}
+			out << '"';
+		}
+
+		// Microseconds with a decimal, from nanoseconds
+		void write_microseconds(std::ostream & out, std::uint64_t nanoseconds)
+		{
+			out << nanoseconds / 1000 << '.' << (nanoseconds % 1000) / 100;
+		}
+
+	}
+
+	std::uint64_t now()
+	{
+		using clock = std::chrono::steady_clock;
+		static clock::time_point const start = clock::now();
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+	}
+
+	void record(char const * name, std::uint64_t begin, std::uint64_t end)
+	{
+		current_buffer().events.push({name, begin, end});
+	}
+
+	void record_counters(char const * name, std::uint64_t time, perf_values const & values)
+	{
+		current_buffer().counters.push({name, time, values});
+	}
+
+	void set_thread_name(char const * name)
+	{
+		// The name lives in the thread's buffer, which nothing else would allocate
+		if constexpr (enabled)
+			current_buffer().name.store(name, std::memory_order_relaxed);
+	}
+
+	bool write_chrome_trace(std::filesystem::path const & path)
+	{
+		std::ofstream file(path);
+		if (!file)
+			return false;
+
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+		bool first = true;
+		auto separator = [&]{ file << (first ? "\n" : ",\n"); first = false; };
+
+		auto & registry = global_registry();
+		std::lock_guard lock{registry.mutex};
+
+		for (auto const & buffer : registry.buffers)
+		{
+			if (auto name = buffer->name.load(std::memory_order_relaxed))
+			{
+				separator();
+				file << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->id << ",\"args\":{\"name\":";
+				write_string(file, name);
+				file << "}}";
+			}
+
+			for (auto const & event : buffer->events.read())
+			{
+				separator();
+				file << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id << ",\"name\":";
+				write_string(file, event.name);
+				file << ",\"ts\":";
+				write_microseconds(file, event.begin);
+				file << ",\"dur\":";
+				write_microseconds(file, event.end - event.begin);
+				file << "}";
+			}
+
+			// Counter tracks are per process, so they are named after the thread too
+			for (auto const & sample : buffer->counters.read())
+			{
+				separator();
+				file << "{\"ph\":\"C\",\"pid\":1,\"tid\":" << buffer->id << ",\"name\":";
+				write_string(file, (sample.name + std::string(" (thread ") + std::to_string(buffer->id) + ")").c_str());
+				file << ",\"ts\":";
+				write_microseconds(file, sample.time);
+				file << ",\"args\":{";
+
+				bool first_value = true;
+				for (std::size_t i = 0; i < perf_counter_count; ++i)
+				{
+					if (!sample.values.has(perf_counter(i)))
+						continue;
+
+					file << (first_value ? "" : ",") << '"' << perf_counter_names[i] << "\":" << sample.values.values[i];
+					first_value = false;
+				}
+
+				file << "}}";
+			}
+		}
+
+		file << "\n]}\n";
+
+		return bool(file);
+	}
+
+}
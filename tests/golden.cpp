@@ -0,0 +1,901 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <rasterizer/renderer.hpp>
+#include <rasterizer/capture.hpp>
+#include <rasterizer/shader.hpp>
+#include <rasterizer/image.hpp>
+#include <rasterizer/cube.hpp>
+#include <rasterizer/primitives.hpp>
+#include <rasterizer/texture.hpp>
+#include <rasterizer/compressed_texture.hpp>
+#include <rasterizer/compressed_depth.hpp>
+
+using namespace rasterizer;
+
+// Renders canonical scenes and compares them against reference images, or times them
+// against a performance baseline
+//
+// Images: every case is rendered at 64x64 and compared to <references>/<case>.ppm; a pixel
+// differs when any channel is off by more than --tolerance, and a case fails when more
+// than --max-bad-fraction of its pixels differ. Failing cases write their image and a
+// difference image to --output. --update rewrites the references instead.
+//
+// Performance (--perf BASELINE): every case is rendered at 256x256 and its fastest time
+// over several repetitions is compared to the baseline file, failing when it is slower
+// by more than --threshold. --update-baseline writes the file instead. Baselines only
+// mean something on the machine and build type they were recorded with, so a missing
+// baseline skips the test (exit code 77).
+//
+// Replays (--replay DIR): every case is captured to DIR while it renders, then replayed, and
+// the replay has to produce the same color buffer, pixel for pixel. Cases drawing with custom
+// shaders are skipped, captures only record draw_commands. With --truncate, every capture is
+// also loaded cut short at many lengths, which has to fail cleanly or keep whole frames only.
+
+namespace
+{
+
+	enum class depth_format
+	{
+		none,
+		d32,
+		d24,
+		d16,
+		reversed_float,
+		compressed,
+	};
+
+	struct resources
+	{
+		texture<color4ub> pattern;
+		compressed_texture<bc1_block> pattern_bc1;
+		compressed_texture<bc3_block> pattern_bc3;
+
+		std::vector<directional_light> directional_lights;
+		std::vector<point_light> point_lights;
+
+		// The cube in compressed vertex formats, colors as color4ub
+		packed_mesh_data packed_cube;
+		std::vector<color4ub> packed_cube_colors;
+	};
+
+	struct test_case
+	{
+		std::string name;
+		depth_format depth = depth_format::d32;
+		image_layout layout = image_layout::linear;
+
+		// Normalized, encoded for the depth format
+		float clear_depth = 1.f;
+
+		// Renders into the middle of the target only, leaving a cleared border
+		bool inset_viewport = false;
+
+		std::function<void(resources const &, std::vector<draw_command> &)> record = {};
+
+		// Draws with custom shaders, after the recorded commands
+		std::function<void(resources const &, framebuffer const &, viewport const &)> shade = {};
+	};
+
+	// 64x64 texture with distinct texels at every scale: a color gradient, a checkerboard
+	// and a white border, so that filtering & mip selection changes show up
+	texture<color4ub> make_pattern()
+	{
+		auto base = image<color4ub>::allocate(64, 64);
+
+		for (std::uint32_t y = 0; y < 64; ++y)
+		{
+			for (std::uint32_t x = 0; x < 64; ++x)
+			{
+				bool border = x == 0 || y == 0 || x == 63 || y == 63;
+				bool check = ((x / 8) + (y / 8)) % 2 == 0;
+
+				base.at(x, y) = border ? color4ub{255, 255, 255, 255} : color4ub
+				{
+					std::uint8_t(x * 4),
+					std::uint8_t(check ? 200 : 40),
+					std::uint8_t(y * 4),
+					255,
+				};
+			}
+		}
+
+		texture<color4ub> result;
+		result.mipmaps.push_back(std::move(base));
+		generate_mipmaps(result);
+		return result;
+	}
+
+	void make_packed_cube(resources & resources)
+	{
+		std::uint32_t vertex_count = *std::max_element(cube.indices, cube.indices + cube.count) + 1;
+
+		mesh_data data{.positions = {}, .normals = {}, .texcoords = {}, .indices = {cube.indices, cube.indices + cube.count}};
+
+		for (std::uint32_t i = 0; i < vertex_count; ++i)
+		{
+			data.positions.push_back(cube.positions[i]);
+			data.normals.push_back(cube.normals[i]);
+			data.texcoords.push_back(cube.texcoords[i]);
+			resources.packed_cube_colors.push_back(to_color4ub(cube.colors[i]));
+		}
+
+		resources.packed_cube = pack(data);
+	}
+
+	matrix4x4f projection(float near = 0.1f, float far = 100.f)
+	{
+		return matrix4x4f::perspective(near, far, M_PIf / 3.f, 1.f);
+	}
+
+	// For reversed_float depth buffers
+	matrix4x4f projection_reversed(float near = 0.1f, float far = 100.f)
+	{
+		return matrix4x4f::perspective_reversed(near, far, M_PIf / 3.f, 1.f);
+	}
+
+	// The cube seen from above and to the side, so that three faces show
+	draw_command cube_command(float distance = 4.f, matrix4x4f const & model = matrix4x4f::identity())
+	{
+		return draw_command
+		{
+			.mesh = cube,
+			.cull_mode = cull_mode::cw,
+			.depth = {
+				.write = true,
+				.mode = depth_test_mode::less,
+			},
+			.model = model,
+			.view = matrix4x4f::translate({0.f, 0.f, -distance}) * matrix4x4f::rotateYZ(M_PIf / 7.f) * matrix4x4f::rotateZX(M_PIf / 5.f),
+			.projection = projection(),
+		};
+	}
+
+	draw_command textured(draw_command command, resources const & resources, filtering filter)
+	{
+		command.albedo = texture_and_sampler
+		{
+			.texture = &resources.pattern,
+			.sampler = {.mag_filter = filter, .min_filter = filter},
+		};
+		return command;
+	}
+
+	draw_command lit(draw_command command, resources const & resources, bool point_lights)
+	{
+		command.lights = light_settings
+		{
+			.ambient_light = {0.2f, 0.2f, 0.2f},
+			.directional_lights = resources.directional_lights,
+			.point_lights = point_lights ? std::span<point_light const>(resources.point_lights) : std::span<point_light const>(),
+		};
+		return command;
+	}
+
+	std::vector<test_case> make_cases()
+	{
+		std::vector<test_case> cases;
+
+		auto single = [](auto make_command)
+		{
+			return [make_command](resources const & resources, std::vector<draw_command> & commands)
+			{
+				commands.push_back(make_command(resources));
+			};
+		};
+
+		// Cull modes, on a cube drawn without depth testing so that hidden faces show
+		for (auto [name, mode] : {std::pair{"cull-none", cull_mode::none}, std::pair{"cull-cw", cull_mode::cw}, std::pair{"cull-ccw", cull_mode::ccw}})
+		{
+			cases.push_back({.name = name, .depth = depth_format::none, .record = single([mode](resources const &)
+			{
+				auto command = cube_command();
+				command.cull_mode = mode;
+				command.depth = {.write = false, .mode = depth_test_mode::always};
+				return command;
+			})});
+		}
+
+		// Depth tests, with culling off so that the far faces compete with the near ones
+		struct depth_case
+		{
+			char const * name;
+			depth_test_mode mode;
+			float clear_depth;
+		};
+
+		for (auto const & c : {
+			depth_case{"depth-less", depth_test_mode::less, 1.f},
+			depth_case{"depth-less-equal", depth_test_mode::less_equal, 1.f},
+			depth_case{"depth-greater", depth_test_mode::greater, 0.f},
+			depth_case{"depth-always", depth_test_mode::always, 1.f},
+			depth_case{"depth-never", depth_test_mode::never, 1.f},
+		})
+		{
+			cases.push_back({.name = c.name, .clear_depth = c.clear_depth, .record = single([mode = c.mode](resources const &)
+			{
+				auto command = cube_command();
+				command.cull_mode = cull_mode::none;
+				command.depth.mode = mode;
+				return command;
+			})});
+		}
+
+		// A depth-only pass, then color where depth is equal
+		cases.push_back({.name = "depth-prepass-equal", .record = [](resources const & resources, std::vector<draw_command> & commands)
+		{
+			auto prepass = cube_command();
+			prepass.cull_mode = cull_mode::none;
+			commands.push_back(prepass);
+
+			auto color = textured(prepass, resources, filtering::linear);
+			color.depth = {.write = false, .mode = depth_test_mode::equal};
+			commands.push_back(color);
+		}});
+
+		// Depth formats, on two intersecting cubes
+		for (auto [name, format] : {
+			std::pair{"format-d24", depth_format::d24},
+			std::pair{"format-d16", depth_format::d16},
+			std::pair{"format-reversed-float", depth_format::reversed_float},
+			std::pair{"format-compressed", depth_format::compressed},
+			std::pair{"format-d32", depth_format::d32},
+		})
+		{
+			cases.push_back({.name = name, .depth = format, .record = [format](resources const &, std::vector<draw_command> & commands)
+			{
+				bool const reversed = format == depth_format::reversed_float;
+
+				// No coplanar faces, so that only the intersection tells the formats apart
+				for (auto const & model : {matrix4x4f::scale({1.2f, 0.5f, 0.5f}), matrix4x4f::rotateXY(M_PIf / 4.f) * matrix4x4f::scale({1.2f, 0.4f, 0.7f})})
+				{
+					auto command = cube_command(4.f, model);
+					if (reversed)
+					{
+						command.depth.mode = depth_test_mode::greater;
+						command.projection = projection_reversed();
+					}
+					commands.push_back(command);
+				}
+			}});
+		}
+
+		// Filtering, magnified & minified
+		cases.push_back({.name = "filter-nearest", .record = single([](resources const & resources){ return textured(cube_command(2.2f), resources, filtering::nearest); })});
+		cases.push_back({.name = "filter-linear", .record = single([](resources const & resources){ return textured(cube_command(2.2f), resources, filtering::linear); })});
+		cases.push_back({.name = "filter-minified", .record = single([](resources const & resources){ return textured(cube_command(7.f), resources, filtering::linear); })});
+		cases.push_back({.name = "filter-bc1", .record = single([](resources const & resources)
+		{
+			auto command = textured(cube_command(2.2f), resources, filtering::linear);
+			command.albedo->texture = &resources.pattern_bc1;
+			return command;
+		})});
+		cases.push_back({.name = "filter-bc3", .record = single([](resources const & resources)
+		{
+			auto command = textured(cube_command(2.2f), resources, filtering::linear);
+			command.albedo->texture = &resources.pattern_bc3;
+			return command;
+		})});
+
+		// Clipping against the near & far planes
+		cases.push_back({.name = "clip-near", .record = single([](resources const & resources)
+		{
+			auto command = textured(cube_command(), resources, filtering::linear);
+			command.cull_mode = cull_mode::none;
+			command.projection = projection(3.6f);
+			return command;
+		})});
+		cases.push_back({.name = "clip-far", .record = single([](resources const & resources)
+		{
+			auto command = textured(cube_command(), resources, filtering::linear);
+			command.projection = projection(0.1f, 4.2f);
+			return command;
+		})});
+
+		// Lighting
+		cases.push_back({.name = "light-vertex-colors", .record = single([](resources const &){ return cube_command(); })});
+		cases.push_back({.name = "light-directional", .record = single([](resources const & resources){ return lit(textured(cube_command(), resources, filtering::linear), resources, false); })});
+		cases.push_back({.name = "light-point", .record = single([](resources const & resources){ return lit(cube_command(), resources, true); })});
+
+		// Compressed vertex formats: a lit cube with vertex colors next to a textured one
+		cases.push_back({.name = "format-packed-vertices", .record = [](resources const & resources, std::vector<draw_command> & commands)
+		{
+			auto packed = resources.packed_cube.view();
+			packed.colors = {resources.packed_cube_colors.data(), sizeof(color4ub), attribute_format::unorm8};
+
+			for (bool texture : {false, true})
+			{
+				auto command = lit(cube_command(4.f, matrix4x4f::translate({texture ? 0.7f : -0.7f, 0.f, 0.f}) * matrix4x4f::scale(0.6f)), resources, true);
+				command.mesh = packed;
+
+				commands.push_back(texture ? textured(command, resources, filtering::linear) : command);
+			}
+		}});
+
+		// Tiled buffers & a viewport covering part of the target
+		cases.push_back({.name = "layout-tiled", .layout = image_layout::tiled, .record = single([](resources const & resources)
+		{
+			return lit(textured(cube_command(), resources, filtering::linear), resources, true);
+		})});
+		cases.push_back({.name = "viewport-inset", .inset_viewport = true, .record = single([](resources const & resources)
+		{
+			return textured(cube_command(), resources, filtering::linear);
+		})});
+
+		// Custom shaders: normals as colors, modulated by the pattern sampled with quad derivatives
+		cases.push_back({.name = "shader-custom", .shade = [](resources const & resources, framebuffer const & framebuffer, viewport const & viewport)
+		{
+			struct varyings
+			{
+				vector3f normal;
+				vector2f texcoord;
+			};
+
+			auto const command = cube_command(2.6f);
+			auto const view_projection = command.projection * command.view;
+
+			sampler const sampler{.mag_filter = filtering::linear, .min_filter = filtering::linear};
+			texel_fetcher<texture<color4ub>> fetch;
+
+			draw(framebuffer, viewport, shader_command
+			{
+				.vertex_shader = [&](std::uint32_t index)
+				{
+					return shaded_vertex<varyings>
+					{
+						.position = view_projection * as_point(cube.positions[index]),
+						.varyings = {
+							.normal = cube.normals[index],
+							.texcoord = cube.texcoords[index],
+						},
+					};
+				},
+				.fragment_shader = [&](fragment<varyings> const & pixel)
+				{
+					vector2f texcoord[2][2];
+					pixel.quad(&varyings::texcoord, texcoord);
+
+					auto albedo = sample(resources.pattern, sampler, fetch, texcoord, pixel.dx, pixel.dy);
+					auto tint = 0.5f * normalized(pixel.varying(&varyings::normal)) + vector3f{0.5f, 0.5f, 0.5f};
+
+					return vector4f{albedo.x * tint.x, albedo.y * tint.y, albedo.z * tint.z, 1.f};
+				},
+				.indices = cube.indices,
+				.count = cube.count,
+				.cull_mode = command.cull_mode,
+				.depth = command.depth,
+			});
+		}});
+
+		return cases;
+	}
+
+	// Buffers of one case
+	struct target
+	{
+		image<color4ub> color;
+		image<std::uint32_t> depth32;
+		image<depth24> depth24_buffer;
+		image<std::uint16_t> depth16;
+		image<float> depth_float;
+		compressed_depth_buffer depth_compressed;
+		struct framebuffer buffers;
+
+		target(test_case const & c, std::uint32_t size)
+		{
+			image_allocation allocation{.layout = c.layout};
+
+			color = image<color4ub>::allocate(size, size, allocation);
+			buffers.color = color.view();
+
+			switch (c.depth)
+			{
+			case depth_format::none:
+				buffers.depth = image_view<std::uint32_t>{};
+				break;
+			case depth_format::d32:
+				depth32 = image<std::uint32_t>::allocate(size, size, allocation);
+				buffers.depth = depth32.view();
+				break;
+			case depth_format::d24:
+				depth24_buffer = image<depth24>::allocate(size, size, allocation);
+				buffers.depth = depth24_buffer.view();
+				break;
+			case depth_format::d16:
+				depth16 = image<std::uint16_t>::allocate(size, size, allocation);
+				buffers.depth = depth16.view();
+				break;
+			case depth_format::reversed_float:
+				depth_float = image<float>::allocate(size, size, allocation);
+				buffers.depth = depth_float.view();
+				break;
+			case depth_format::compressed:
+				depth_compressed = compressed_depth_buffer::allocate(size, size);
+				buffers.depth = depth_compressed.view();
+				break;
+			}
+		}
+
+		void render(test_case const & c, resources const & resources, std::vector<draw_command> const & commands, std::uint32_t size)
+		{
+			viewport viewport{.xmin = 0, .ymin = 0, .xmax = (std::int32_t)size, .ymax = (std::int32_t)size};
+			if (c.inset_viewport)
+				viewport = {.xmin = (std::int32_t)size / 4, .ymin = (std::int32_t)size / 8, .xmax = (std::int32_t)size * 7 / 8, .ymax = (std::int32_t)size * 3 / 4};
+
+			clear(buffers.color, {0.1f, 0.1f, 0.15f, 1.f});
+			if (c.depth != depth_format::none)
+				clear(buffers.depth, c.clear_depth);
+
+			for (auto const & command : commands)
+				draw(buffers, viewport, command);
+
+			if (c.shade)
+				c.shade(resources, buffers, viewport);
+		}
+	};
+
+	struct settings
+	{
+		std::filesystem::path references;
+		std::filesystem::path output = ".";
+		bool update = false;
+		int tolerance = 8;
+		double max_bad_fraction = 0.002;
+
+		std::filesystem::path baseline;
+		bool update_baseline = false;
+		double threshold = 0.25;
+
+		std::filesystem::path captures;
+		bool truncate = false;
+
+		std::vector<std::string> filters;
+	};
+
+	bool selected(settings const & settings, std::string const & name)
+	{
+		if (settings.filters.empty())
+			return true;
+
+		for (auto const & filter : settings.filters)
+			if (name.find(filter) != std::string::npos)
+				return true;
+
+		return false;
+	}
+
+	// Linear copy, so that images of any layout can be compared & saved the same way
+	image<color4ub> linear_copy(image_view<color4ub> const & view)
+	{
+		auto result = image<color4ub>::allocate(view.width, view.height);
+		copy(view, result.view());
+		return result;
+	}
+
+	bool compare(settings const & settings, test_case const & c, image<color4ub> const & actual)
+	{
+		auto reference_path = settings.references / (c.name + ".ppm");
+
+		if (settings.update)
+		{
+			if (!save_image(reference_path, actual.view()))
+			{
+				std::printf("FAIL %s: could not write %s\n", c.name.c_str(), reference_path.string().c_str());
+				return false;
+			}
+
+			std::printf("updated %s\n", c.name.c_str());
+			return true;
+		}
+
+		auto reference = load_image(reference_path);
+
+		if (!reference || reference.width != actual.width || reference.height != actual.height)
+		{
+			std::printf("FAIL %s: missing or mismatched reference %s\n", c.name.c_str(), reference_path.string().c_str());
+			save_image(settings.output / (c.name + ".actual.ppm"), actual.view());
+			return false;
+		}
+
+		auto difference = image<color4ub>::allocate(actual.width, actual.height);
+
+		std::uint32_t bad_pixels = 0;
+		int max_error = 0;
+
+		for (std::uint32_t y = 0; y < actual.height; ++y)
+		{
+			for (std::uint32_t x = 0; x < actual.width; ++x)
+			{
+				auto a = actual.at(x, y);
+				auto r = reference.at(x, y);
+
+				int error = std::max({std::abs(a.r - r.r), std::abs(a.g - r.g), std::abs(a.b - r.b)});
+				max_error = std::max(max_error, error);
+
+				if (error > settings.tolerance)
+					++bad_pixels;
+
+				// Differences beyond the tolerance in red, within it in gray
+				difference.at(x, y) = error > settings.tolerance ? color4ub{255, 0, 0, 255} : color4ub{std::uint8_t(error * 16), std::uint8_t(error * 16), std::uint8_t(error * 16), 255};
+			}
+		}
+
+		double bad_fraction = double(bad_pixels) / (actual.width * actual.height);
+		bool passed = bad_fraction <= settings.max_bad_fraction;
+
+		std::printf("%s %s: %u pixels off by more than %d, max error %d\n", passed ? "ok  " : "FAIL", c.name.c_str(), bad_pixels, settings.tolerance, max_error);
+
+		if (!passed)
+		{
+			save_image(settings.output / (c.name + ".actual.ppm"), actual.view());
+			save_image(settings.output / (c.name + ".diff.ppm"), difference.view());
+		}
+
+		return passed;
+	}
+
+	int run_images(settings const & settings, resources const & resources, std::vector<test_case> const & cases)
+	{
+		constexpr std::uint32_t size = 64;
+
+		std::error_code error;
+		std::filesystem::create_directories(settings.update ? settings.references : settings.output, error);
+
+		int failures = 0;
+
+		for (auto const & c : cases)
+		{
+			if (!selected(settings, c.name))
+				continue;
+
+			std::vector<draw_command> commands;
+			if (c.record)
+				c.record(resources, commands);
+
+			target target(c, size);
+			target.render(c, resources, commands, size);
+
+			if (!compare(settings, c, linear_copy(target.buffers.color)))
+				++failures;
+		}
+
+		if (failures > 0)
+			std::printf("%d cases failed, their images are in %s\n", failures, settings.output.string().c_str());
+
+		return failures == 0 ? 0 : 1;
+	}
+
+	bool same_pixels(image_view<color4ub> const & a, image_view<color4ub> const & b)
+	{
+		if (a.width != b.width || a.height != b.height)
+			return false;
+
+		for (std::uint32_t y = 0; y < a.height; ++y)
+		{
+			for (std::uint32_t x = 0; x < a.width; ++x)
+			{
+				auto const & p = a.at(x, y);
+				auto const & q = b.at(x, y);
+				if (p.r != q.r || p.g != q.g || p.b != q.b || p.a != q.a)
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Loads the first size bytes of the capture; a replay that still loads is played
+	// through, to catch records read past what was validated
+	bool load_truncated(std::filesystem::path const & path, std::vector<char> const & data, std::size_t size)
+	{
+		{
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			file.write(data.data(), size);
+			if (!file)
+				return false;
+		}
+
+		auto replay = capture::replay::load(path);
+
+		for (std::size_t frame = 0; replay && frame < replay.frame_count(); ++frame)
+			replay.play(frame);
+
+		// Cut before the end, there's no complete frame left
+		return !replay || size == data.size();
+	}
+
+	int run_replays(settings const & settings, resources const & resources, std::vector<test_case> const & cases)
+	{
+		constexpr std::uint32_t size = 64;
+
+		std::error_code error;
+		std::filesystem::create_directories(settings.captures, error);
+
+		int failures = 0;
+
+		for (auto const & c : cases)
+		{
+			if (!selected(settings, c.name) || c.shade)
+				continue;
+
+			std::vector<draw_command> commands;
+			if (c.record)
+				c.record(resources, commands);
+
+			auto path = settings.captures / (c.name + ".capture");
+
+			target target(c, size);
+
+			if (!capture::start(path))
+			{
+				std::printf("FAIL %s: could not write %s\n", c.name.c_str(), path.string().c_str());
+				++failures;
+				continue;
+			}
+
+			target.render(c, resources, commands, size);
+			capture::end_frame();
+			capture::stop();
+
+			auto replay = capture::replay::load(path);
+
+			bool passed = replay && replay.frame_count() == 1 && replay.color_buffer_count() == 1;
+
+			if (passed)
+			{
+				replay.play(0);
+				passed = same_pixels(replay.color_buffer(0), target.buffers.color);
+			}
+
+			if (passed && settings.truncate)
+			{
+				std::ifstream file(path, std::ios::binary);
+				std::vector<char> data{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+
+				auto truncated_path = settings.captures / (c.name + ".truncated.capture");
+
+				// Every length near the start and the end, where the headers & the end of frame
+				// marker are, and a spread of lengths in between
+				for (std::size_t length = 0; passed && length <= data.size(); ++length)
+				{
+					if (length >= 256 && length + 256 < data.size() && length % 61 != 0)
+						continue;
+
+					if (!load_truncated(truncated_path, data, length))
+					{
+						std::printf("FAIL %s: replayed a frame from the first %zu of %zu bytes\n", c.name.c_str(), length, data.size());
+						passed = false;
+					}
+				}
+
+				std::filesystem::remove(truncated_path, error);
+			}
+
+			std::printf("%s %s\n", passed ? "ok  " : "FAIL", c.name.c_str());
+
+			if (!passed)
+			{
+				save_image(settings.captures / (c.name + ".rendered.ppm"), linear_copy(target.buffers.color).view());
+				if (replay)
+					save_image(settings.captures / (c.name + ".replayed.ppm"), linear_copy(replay.color_buffer(0)).view());
+				++failures;
+			}
+		}
+
+		if (failures > 0)
+			std::printf("%d cases didn't replay to the same image, their captures are in %s\n", failures, settings.captures.string().c_str());
+
+		return failures == 0 ? 0 : 1;
+	}
+
+	// Fastest of several repetitions, each running enough frames to last a few milliseconds
+	double time_case(resources const & resources, test_case const & c)
+	{
+		using clock = std::chrono::steady_clock;
+
+		constexpr std::uint32_t size = 256;
+
+		std::vector<draw_command> commands;
+		if (c.record)
+			c.record(resources, commands);
+
+		target target(c, size);
+
+		std::uint32_t frames = 1;
+		for (;;)
+		{
+			auto start = clock::now();
+			for (std::uint32_t i = 0; i < frames; ++i)
+				target.render(c, resources, commands, size);
+			if (clock::now() - start > std::chrono::milliseconds(5) || frames >= (1u << 16))
+				break;
+			frames *= 2;
+		}
+
+		double best = 1e30;
+
+		for (int repetition = 0; repetition < 15; ++repetition)
+		{
+			auto start = clock::now();
+			for (std::uint32_t i = 0; i < frames; ++i)
+				target.render(c, resources, commands, size);
+			best = std::min(best, std::chrono::duration<double, std::micro>(clock::now() - start).count() / frames);
+		}
+
+		return best;
+	}
+
+	int run_performance(settings const & settings, resources const & resources, std::vector<test_case> const & cases)
+	{
+		std::map<std::string, double> baseline;
+
+		if (!settings.update_baseline)
+		{
+			std::ifstream file(settings.baseline);
+
+			if (!file)
+			{
+				std::printf("No baseline at %s, record one with --update-baseline\n", settings.baseline.string().c_str());
+				return 77;
+			}
+
+			std::string name;
+			double microseconds;
+			while (file >> name >> microseconds)
+				baseline[name] = microseconds;
+		}
+
+		std::map<std::string, double> timings;
+		int failures = 0;
+
+		for (auto const & c : cases)
+		{
+			if (!selected(settings, c.name))
+				continue;
+
+			double microseconds = time_case(resources, c);
+			timings[c.name] = microseconds;
+
+			if (settings.update_baseline)
+			{
+				std::printf("     %-24s %10.1f us\n", c.name.c_str(), microseconds);
+				continue;
+			}
+
+			auto it = baseline.find(c.name);
+			if (it == baseline.end())
+			{
+				std::printf("     %-24s %10.1f us, not in the baseline\n", c.name.c_str(), microseconds);
+				continue;
+			}
+
+			double change = microseconds / it->second - 1.0;
+			bool passed = change <= settings.threshold;
+
+			if (!passed)
+				++failures;
+
+			std::printf("%s %-24s %10.1f us, baseline %10.1f us, %+6.1f%%\n", passed ? "ok  " : "FAIL", c.name.c_str(), microseconds, it->second, 100.0 * change);
+		}
+
+		if (settings.update_baseline)
+		{
+			// Cases that weren't run keep their previous timings
+			{
+				std::ifstream file(settings.baseline);
+				std::string name;
+				double microseconds;
+				while (file >> name >> microseconds)
+					timings.emplace(name, microseconds);
+			}
+
+			std::ofstream file(settings.baseline);
+			for (auto const & [name, microseconds] : timings)
+				file << name << ' ' << microseconds << '\n';
+
+			if (!file)
+			{
+				std::printf("Could not write %s\n", settings.baseline.string().c_str());
+				return 1;
+			}
+
+			std::printf("Wrote %s\n", settings.baseline.string().c_str());
+			return 0;
+		}
+
+		if (failures > 0)
+			std::printf("%d cases are more than %.0f%% slower than the baseline\n", failures, 100.0 * settings.threshold);
+
+		return failures == 0 ? 0 : 1;
+	}
+
+	int usage()
+	{
+		std::fprintf(stderr,
+			"usage: tiny-rasterizer-golden [options] [filter...]\n"
+			"  Runs the cases whose name contains any of the filters, or all of them\n"
+			"  --references DIR        reference images (required without --perf or --replay)\n"
+			"  --output DIR            where failing cases write their images (.)\n"
+			"  --update                rewrite the references\n"
+			"  --tolerance N           largest channel difference of a matching pixel (8)\n"
+			"  --max-bad-fraction F    fraction of pixels allowed to differ (0.002)\n"
+			"  --perf FILE             compare timings to the baseline in FILE instead\n"
+			"  --update-baseline       rewrite the baseline\n"
+			"  --threshold F           allowed slowdown against the baseline (0.25)\n"
+			"  --replay DIR            capture & replay the cases into DIR instead\n"
+			"  --truncate              also load the captures cut short\n");
+		return 2;
+	}
+
+}
+
+int main(int argc, char ** argv)
+{
+	settings settings;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string_view argument = argv[i];
+
+		if (argument == "--update")
+			settings.update = true;
+		else if (argument == "--update-baseline")
+			settings.update_baseline = true;
+		else if (argument == "--truncate")
+			settings.truncate = true;
+		else if (argument == "--references" && i + 1 < argc)
+			settings.references = argv[++i];
+		else if (argument == "--output" && i + 1 < argc)
+			settings.output = argv[++i];
+		else if (argument == "--tolerance" && i + 1 < argc)
+			settings.tolerance = std::atoi(argv[++i]);
+		else if (argument == "--max-bad-fraction" && i + 1 < argc)
+			settings.max_bad_fraction = std::atof(argv[++i]);
+		else if (argument == "--perf" && i + 1 < argc)
+			settings.baseline = argv[++i];
+		else if (argument == "--threshold" && i + 1 < argc)
+			settings.threshold = std::atof(argv[++i]);
+		else if (argument == "--replay" && i + 1 < argc)
+			settings.captures = argv[++i];
+		else if (argument.starts_with("--"))
+			return usage();
+		else
+			settings.filters.emplace_back(argument);
+	}
+
+	if (settings.baseline.empty() && settings.references.empty() && settings.captures.empty())
+		return usage();
+
+	resources resources;
+	resources.pattern = make_pattern();
+	resources.pattern_bc1 = compress_bc1(resources.pattern);
+	resources.pattern_bc3 = compress_bc3(resources.pattern);
+	resources.directional_lights = {{normalized(vector3f{1.f, 2.f, 3.f}), {0.8f, 0.8f, 0.7f}}};
+	resources.point_lights =
+	{
+		{.position = {2.f, 2.f, 2.f}, .intensity = {1.f, 0.3f, 0.3f}, .attenuation = {1.f, 0.f, 0.2f}},
+		{.position = {-2.f, 1.f, 2.f}, .intensity = {0.3f, 0.3f, 1.f}, .attenuation = {1.f, 0.f, 0.2f}},
+	};
+
+	make_packed_cube(resources);
+
+	auto cases = make_cases();
+
+	if (!settings.baseline.empty())
+		return run_performance(settings, resources, cases);
+
+	if (!settings.captures.empty())
+		return run_replays(settings, resources, cases);
+
+	return run_images(settings, resources, cases);
+}
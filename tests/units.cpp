@@ -0,0 +1,630 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <rasterizer/image.hpp>
+#include <rasterizer/color.hpp>
+#include <rasterizer/compressed_depth.hpp>
+#include <rasterizer/compressed_texture.hpp>
+#include <rasterizer/heatmap.hpp>
+#include <rasterizer/matrix.hpp>
+#include <rasterizer/renderer.hpp>
+#include <rasterizer/shader.hpp>
+#include <rasterizer/texture_file.hpp>
+
+using namespace rasterizer;
+
+// Checks of the pieces that the golden images don't exercise directly: conversions between
+// layouts and formats, round trips through encoders and file formats
+//
+// Every check prints its failures and the test fails when any does; filters select the
+// checks whose name contains any of them
+
+namespace
+{
+
+	int failures = 0;
+
+	void expect(bool condition, char const * what, char const * file, int line)
+	{
+		if (condition)
+			return;
+
+		std::printf("  %s:%d: %s\n", file, line, what);
+		++failures;
+	}
+
+#define EXPECT(condition) expect((condition), #condition, __FILE__, __LINE__)
+
+	struct check
+	{
+		std::string name;
+		std::function<void()> run;
+	};
+
+	// Distinct values per pixel, so that misplaced pixels show up
+	color4ub pixel_pattern(std::uint32_t x, std::uint32_t y)
+	{
+		return {std::uint8_t(x * 7 + 1), std::uint8_t(y * 13 + 2), std::uint8_t(x ^ y), 255};
+	}
+
+	// Largest channel difference, alpha included
+	int max_error(color4ub const * a, color4ub const * b, int count)
+	{
+		int result = 0;
+		for (int i = 0; i < count; ++i)
+			result = std::max({result, std::abs(a[i].r - b[i].r), std::abs(a[i].g - b[i].g), std::abs(a[i].b - b[i].b), std::abs(a[i].a - b[i].a)});
+		return result;
+	}
+
+	// Blocks of 16 texels in row-major order: one color, and a gradient from left to right
+	// between two colors with alpha going the other way, in the 4 steps of a BC1 palette
+	void solid_block(color4ub color, color4ub * texels)
+	{
+		std::fill(texels, texels + 16, color);
+	}
+
+	void gradient_block(color4ub from, color4ub to, color4ub * texels)
+	{
+		for (int i = 0; i < 16; ++i)
+		{
+			int t = i % 4;
+			auto mix = [t](int a, int b){ return std::uint8_t((a * (3 - t) + b * t) / 3); };
+			texels[i] = {mix(from.r, to.r), mix(from.g, to.g), mix(from.b, to.b), mix(to.a, from.a)};
+		}
+	}
+
+	std::vector<char> read_file(std::filesystem::path const & path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+	}
+
+	void write_file(std::filesystem::path const & path, std::vector<char> const & data)
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write(data.data(), data.size());
+	}
+
+	// Removed with everything in it when the check ends
+	struct scratch_directory
+	{
+		std::filesystem::path path = std::filesystem::temp_directory_path() / ("tiny-rasterizer-units-" + std::to_string(std::random_device{}()));
+
+		scratch_directory()
+		{
+			std::filesystem::create_directories(path);
+		}
+
+		~scratch_directory()
+		{
+			std::error_code error;
+			std::filesystem::remove_all(path, error);
+		}
+	};
+
+	// Sizes that halve to odd ones, down to 1x1
+	texture<color4ub> make_texture()
+	{
+		texture<color4ub> result;
+		result.mipmaps.push_back(image<color4ub>::allocate(37, 21));
+
+		for (std::uint32_t y = 0; y < 21; ++y)
+			for (std::uint32_t x = 0; x < 37; ++x)
+				result.mipmaps[0].at(x, y) = pixel_pattern(x, y);
+
+		generate_mipmaps(result);
+		return result;
+	}
+
+	template <typename Block>
+	bool same_blocks(compressed_texture<Block> const & a, compressed_texture<Block> const & b)
+	{
+		if (a.mipmaps.size() != b.mipmaps.size())
+			return false;
+
+		for (std::size_t i = 0; i < a.mipmaps.size(); ++i)
+		{
+			auto const & x = a.mipmaps[i];
+			auto const & y = b.mipmaps[i];
+			std::size_t count = std::size_t(x.width_in_blocks()) * x.height_in_blocks();
+
+			if (x.width != y.width || x.height != y.height || std::memcmp(x.blocks.get(), y.blocks.get(), count * sizeof(Block)) != 0)
+				return false;
+		}
+
+		return true;
+	}
+
+	bool same_levels(texture<color4ub> const & a, texture<color4ub> const & b)
+	{
+		if (a.mipmaps.size() != b.mipmaps.size())
+			return false;
+
+		for (std::size_t i = 0; i < a.mipmaps.size(); ++i)
+		{
+			auto const & x = a.mipmaps[i];
+			auto const & y = b.mipmaps[i];
+
+			if (x.width != y.width || x.height != y.height)
+				return false;
+
+			for (std::uint32_t py = 0; py < x.height; ++py)
+				for (std::uint32_t px = 0; px < x.width; ++px)
+					if (max_error(&x.at(px, py), &y.at(px, py), 1) != 0)
+						return false;
+		}
+
+		return true;
+	}
+
+	std::vector<check> make_checks()
+	{
+		std::vector<check> checks;
+
+		// Sizes that aren't whole tiles too, so that partial tiles are covered
+		checks.push_back({"convert-layouts", []
+		{
+			for (std::uint32_t size : {16u, 13u})
+			{
+				for (auto source_layout : {image_layout::linear, image_layout::tiled})
+				{
+					for (auto destination_layout : {image_layout::linear, image_layout::tiled})
+					{
+						auto source = image<color4ub>::allocate(size, size, {.layout = source_layout});
+						for (std::uint32_t y = 0; y < size; ++y)
+							for (std::uint32_t x = 0; x < size; ++x)
+								source.at(x, y) = pixel_pattern(x, y);
+
+						auto floats = image<vector4f>::allocate(size, size, {.layout = destination_layout});
+						convert(source.view(), floats.view());
+
+						auto srgb = image<vector4f>::allocate(size, size, {.layout = destination_layout});
+						convert_srgb(source.view(), srgb.view());
+
+						auto back = image<color4ub>::allocate(size, size, {.layout = source_layout});
+						convert(floats.view(), back.view());
+
+						int wrong = 0;
+						for (std::uint32_t y = 0; y < size; ++y)
+						{
+							for (std::uint32_t x = 0; x < size; ++x)
+							{
+								auto expected = to_vector4f(pixel_pattern(x, y));
+								auto expected_srgb = to_vector4f_srgb(pixel_pattern(x, y));
+								auto const & actual = floats.at(x, y);
+								auto const & actual_srgb = srgb.at(x, y);
+								auto const & round_trip = back.at(x, y);
+								auto original = pixel_pattern(x, y);
+
+								wrong += actual.x != expected.x || actual.y != expected.y || actual.z != expected.z || actual.w != expected.w;
+								wrong += actual_srgb.x != expected_srgb.x || actual_srgb.z != expected_srgb.z;
+								wrong += round_trip.r != original.r || round_trip.g != original.g || round_trip.b != original.b || round_trip.a != original.a;
+							}
+						}
+
+						EXPECT(wrong == 0);
+					}
+				}
+			}
+		}});
+
+		// Colors that 5:6:5 holds exactly come back exactly, others within its rounding
+		checks.push_back({"bc-solid", []
+		{
+			for (auto color : {color4ub{255, 0, 0, 255}, color4ub{0, 255, 255, 255}, color4ub{100, 150, 200, 255}, color4ub{0, 0, 0, 255}})
+			{
+				bool exact = color.r != 100;
+
+				color4ub texels[16], bc1[16], bc3[16];
+				solid_block(color, texels);
+
+				decode(encode_bc1(texels), bc1);
+				decode(encode_bc3(texels), bc3);
+
+				EXPECT(max_error(texels, bc1, 16) <= (exact ? 0 : 4));
+				EXPECT(max_error(texels, bc3, 16) <= (exact ? 0 : 4));
+			}
+		}});
+
+		// Gradients only lose 5:6:5 rounding, BC3's alpha is within half of its 8 levels' spacing
+		checks.push_back({"bc-gradient", []
+		{
+			color4ub texels[16], bc1[16], bc3[16];
+			gradient_block({16, 32, 200, 255}, {220, 180, 40, 0}, texels);
+
+			decode(encode_bc3(texels), bc3);
+
+			int color_error = 0;
+			int alpha_error = 0;
+			for (int i = 0; i < 16; ++i)
+			{
+				color_error = std::max({color_error, std::abs(texels[i].r - bc3[i].r), std::abs(texels[i].g - bc3[i].g), std::abs(texels[i].b - bc3[i].b)});
+				alpha_error = std::max(alpha_error, std::abs(texels[i].a - bc3[i].a));
+			}
+
+			EXPECT(color_error <= 4);
+			EXPECT(alpha_error <= 255 / 14 + 1);
+
+			// BC1 alpha is 1 bit, opaque here
+			for (auto & texel : texels)
+				texel.a = 255;
+
+			decode(encode_bc1(texels), bc1);
+			EXPECT(max_error(texels, bc1, 16) <= 4);
+		}});
+
+		// BC3 alpha is encoded between the block's largest and smallest values, which come back
+		// exactly
+		checks.push_back({"bc3-alpha-endpoints", []
+		{
+			color4ub texels[16];
+			solid_block({128, 128, 128, 0}, texels);
+			for (int i = 0; i < 16; ++i)
+				texels[i].a = std::uint8_t(17 + i * 9);
+			texels[5].a = 200;
+
+			auto block = encode_bc3(texels);
+			EXPECT(block.alpha0 == 200);
+			EXPECT(block.alpha1 == 17);
+
+			color4ub decoded[16];
+			decode(block, decoded);
+			EXPECT(decoded[0].a == 17);
+			EXPECT(decoded[5].a == 200);
+
+			solid_block({128, 128, 128, 77}, texels);
+			decode(encode_bc3(texels), decoded);
+			EXPECT(decoded[0].a == 77 && decoded[15].a == 77);
+		}});
+
+		// alpha0 > alpha1 interpolates 6 values between them, otherwise 4 values and 0 & 255
+		checks.push_back({"bc3-alpha-modes", []
+		{
+			auto alphas = [](std::uint8_t alpha0, std::uint8_t alpha1)
+			{
+				// Texel i uses index i % 8
+				std::uint64_t indices = 0;
+				for (std::uint64_t i = 0; i < 16; ++i)
+					indices |= (i % 8) << (3 * i);
+
+				color4ub black[16] = {};
+				bc3_block block{.alpha0 = alpha0, .alpha1 = alpha1, .alpha_indices = {}, .color = encode_bc1(black)};
+				for (int i = 0; i < 6; ++i)
+					block.alpha_indices[i] = (indices >> (8 * i)) & 0xff;
+
+				color4ub texels[16];
+				decode(block, texels);
+
+				std::array<int, 16> result;
+				for (int i = 0; i < 16; ++i)
+					result[i] = texels[i].a;
+				return result;
+			};
+
+			auto eight = alphas(210, 70);
+			std::array<int, 8> const expected_eight = {210, 70, 190, 170, 150, 130, 110, 90};
+			for (int i = 0; i < 16; ++i)
+				EXPECT(eight[i] == expected_eight[i % 8]);
+
+			auto six = alphas(40, 240);
+			std::array<int, 8> const expected_six = {40, 240, 80, 120, 160, 200, 0, 255};
+			for (int i = 0; i < 16; ++i)
+				EXPECT(six[i] == expected_six[i % 8]);
+		}});
+
+		// Fetches decode a block once, until a block mapping to the same slot replaces it
+		checks.push_back({"bc-decoded-block-cache", []
+		{
+			auto image = compressed_image<bc1_block>::allocate(64, 16);
+
+			color4ub texels[16];
+			for (std::uint32_t by = 0; by < image.height_in_blocks(); ++by)
+			{
+				for (std::uint32_t bx = 0; bx < image.width_in_blocks(); ++bx)
+				{
+					gradient_block(pixel_pattern(bx, by), pixel_pattern(by, bx + 3), texels);
+					image.blocks[bx + by * image.width_in_blocks()] = encode_bc1(texels);
+				}
+			}
+
+			// Every texel, in an order that revisits blocks after others took their slot
+			decoded_block_cache<bc1_block> cache;
+			int wrong = 0;
+
+			for (std::uint32_t pass = 0; pass < 2; ++pass)
+			{
+				for (std::uint32_t i = 0; i < image.width * image.height; ++i)
+				{
+					std::uint32_t x = (i * 37 + pass) % image.width;
+					std::uint32_t y = (i / image.width + i * 5) % image.height;
+
+					color4ub expected[16];
+					decode(image.block_at(x / 4, y / 4), expected);
+
+					auto actual = cache.fetch(image, x, y);
+					wrong += max_error(&actual, &expected[(x % 4) + (y % 4) * 4], 1) != 0;
+				}
+			}
+
+			EXPECT(wrong == 0);
+
+			// A hit doesn't decode again: a cached block that changes goes unnoticed until a block
+			// 8 blocks across takes its slot and it's decoded anew
+			color4ub original[16], replaced[16];
+			decode(image.block_at(0, 0), original);
+			cache.fetch(image, 0, 0);
+
+			solid_block({255, 0, 255, 255}, texels);
+			image.blocks[0] = encode_bc1(texels);
+			decode(image.block_at(0, 0), replaced);
+
+			auto hit = cache.fetch(image, 1, 1);
+			cache.fetch(image, 32, 0);
+			auto miss = cache.fetch(image, 1, 1);
+
+			EXPECT(max_error(&original[5], &replaced[5], 1) != 0);
+			EXPECT(max_error(&hit, &original[5], 1) == 0);
+			EXPECT(max_error(&miss, &replaced[5], 1) == 0);
+		}});
+
+		// Every level maps back as it was saved, in all three formats
+		checks.push_back({"texture-file-round-trip", []
+		{
+			scratch_directory directory;
+
+			auto texture = make_texture();
+			auto bc1 = compress_bc1(texture);
+			auto bc3 = compress_bc3(texture);
+
+			EXPECT(save_texture(directory.path / "rgba8.rtex", texture));
+			EXPECT(save_texture(directory.path / "bc1.rtex", bc1));
+			EXPECT(save_texture(directory.path / "bc3.rtex", bc3));
+
+			EXPECT(same_levels(map_texture<rasterizer::texture<color4ub>>(directory.path / "rgba8.rtex"), texture));
+			EXPECT(same_blocks(map_texture<compressed_texture<bc1_block>>(directory.path / "bc1.rtex"), bc1));
+			EXPECT(same_blocks(map_texture<compressed_texture<bc3_block>>(directory.path / "bc3.rtex"), bc3));
+		}});
+
+		// Files cut short anywhere, with a damaged header or level table, or of another format
+		// map to an empty texture
+		checks.push_back({"texture-file-corrupt", []
+		{
+			scratch_directory directory;
+			auto path = directory.path / "texture.rtex";
+
+			auto texture = make_texture();
+			EXPECT(save_texture(path, texture));
+
+			auto const data = read_file(path);
+
+			texture_file_header header;
+			std::memcpy(&header, data.data(), sizeof(header));
+
+			texture_file_level last;
+			std::memcpy(&last, data.data() + sizeof(header) + (header.level_count - 1) * sizeof(last), sizeof(last));
+
+			auto rejects = [&](std::vector<char> const & contents)
+			{
+				write_file(path, contents);
+				return map_texture<rasterizer::texture<color4ub>>(path).mipmaps.empty();
+			};
+
+			for (std::size_t size : {std::size_t(0), std::size_t(3), sizeof(header) - 1, sizeof(header) + header.level_count * sizeof(last) - 1, std::size_t(last.offset + last.size - 1)})
+				EXPECT(rejects({data.begin(), data.begin() + size}));
+
+			auto damaged = data;
+			damaged[0] = 'X';
+			EXPECT(rejects(damaged));
+
+			damaged = data;
+			damaged[offsetof(texture_file_header, version)] = 2;
+			EXPECT(rejects(damaged));
+
+			// Level 0 moved off its alignment, then past the end of the file
+			damaged = data;
+			damaged[sizeof(header) + offsetof(texture_file_level, offset)] += 1;
+			EXPECT(rejects(damaged));
+
+			damaged = data;
+			damaged[sizeof(header) + offsetof(texture_file_level, offset) + 3] = 1;
+			EXPECT(rejects(damaged));
+
+			EXPECT(save_texture(path, compress_bc1(texture)));
+			EXPECT(map_texture<rasterizer::texture<color4ub>>(path).mipmaps.empty());
+
+			EXPECT(map_texture<rasterizer::texture<color4ub>>(directory.path / "missing.rtex").mipmaps.empty());
+		}});
+
+		// The first load writes a container to the cache, the second maps it: a texel changed in
+		// the container shows in the second load
+		checks.push_back({"texture-file-cache", []
+		{
+			scratch_directory directory;
+			auto source = directory.path / "source.ppm";
+			auto cache = directory.path / "cache";
+
+			auto texture = make_texture();
+			EXPECT(save_image(source, texture.mipmaps[0].view()));
+
+			auto first = load_texture_cached(source, cache);
+			EXPECT(same_levels(first, texture));
+
+			std::vector<std::filesystem::path> containers;
+			for (auto const & entry : std::filesystem::directory_iterator(cache))
+				containers.push_back(entry.path());
+
+			EXPECT(containers.size() == 1 && containers[0].extension() == ".rtex");
+			if (containers.size() != 1)
+				return;
+
+			auto data = read_file(containers[0]);
+
+			texture_file_level level;
+			std::memcpy(&level, data.data() + sizeof(texture_file_header), sizeof(level));
+			data[level.offset] ^= 0xff;
+			write_file(containers[0], data);
+
+			auto second = load_texture_cached(source, cache);
+			EXPECT(second.mipmaps.size() == texture.mipmaps.size());
+			EXPECT(!second.mipmaps.empty() && second.mipmaps[0].at(0, 0).r == (texture.mipmaps[0].at(0, 0).r ^ 0xff));
+		}});
+
+		// 13 pixels are a whole tile and a partial one: every pixel takes its own tile's value
+		checks.push_back({"heatmap-tiles", []
+		{
+			auto values = image<std::uint32_t>::allocate(2, 2);
+			for (std::uint32_t y = 0; y < 2; ++y)
+				for (std::uint32_t x = 0; x < 2; ++x)
+					values.at(x, y) = 1 + x + 2 * y;
+
+			auto colors = image<color4ub>::allocate(13, 13);
+			false_color(values.view(), colors.view(), 4);
+
+			auto reference = image<color4ub>::allocate(2, 2);
+			false_color(values.view(), reference.view(), 4);
+
+			int wrong = 0;
+			for (std::uint32_t y = 0; y < 13; ++y)
+			{
+				for (std::uint32_t x = 0; x < 13; ++x)
+				{
+					auto const & actual = colors.at(x, y);
+					auto const & expected = reference.at(x / tile_size, y / tile_size);
+					wrong += actual.r != expected.r || actual.g != expected.g || actual.b != expected.b;
+				}
+			}
+
+			EXPECT(wrong == 0);
+		}});
+
+		// Two parallel quads far from the camera, a 5000th of their distance apart, drawn far one
+		// first: reversed float depth tells them apart everywhere, D32 has them z-fight since
+		// their depths round together near 1
+		checks.push_back({"depth-reversed-float-separation", []
+		{
+			std::uint32_t const size = 16;
+
+			struct varyings
+			{
+				vector4f color;
+			};
+
+			// Pixels where the near quad shows
+			auto near_pixels = [size](depth_view depth, matrix4x4f const & projection, depth_test_mode mode)
+			{
+				auto color = image<color4ub>::allocate(size, size);
+				framebuffer framebuffer{.color = color.view(), .depth = depth};
+				viewport viewport{.xmin = 0, .ymin = 0, .xmax = (std::int32_t)size, .ymax = (std::int32_t)size};
+
+				clear(framebuffer.color, {0.f, 0.f, 0.f, 1.f});
+				clear(framebuffer.depth, 1.f);
+
+				std::uint32_t const indices[] = {0, 1, 2, 2, 1, 3};
+
+				for (auto [distance, quad_color] : {std::pair{5001.f, vector4f{1.f, 0.f, 0.f, 1.f}}, std::pair{5000.f, vector4f{0.f, 1.f, 0.f, 1.f}}})
+				{
+					draw(framebuffer, viewport, shader_command
+					{
+						.vertex_shader = [&](std::uint32_t index)
+						{
+							vector4f corner{(index & 1) ? distance : -distance, (index & 2) ? distance : -distance, -distance, 1.f};
+							return shaded_vertex<varyings>{.position = projection * corner, .varyings = {.color = quad_color}};
+						},
+						.fragment_shader = [](fragment<varyings> const & pixel){ return pixel.varying(&varyings::color); },
+						.indices = indices,
+						.count = 6,
+						.cull_mode = cull_mode::none,
+						.depth = {.write = true, .mode = mode},
+					});
+				}
+
+				int count = 0;
+				for (std::uint32_t y = 0; y < size; ++y)
+					for (std::uint32_t x = 0; x < size; ++x)
+						count += color.at(x, y).g > 128;
+				return count;
+			};
+
+			auto depth32 = image<std::uint32_t>::allocate(size, size);
+			auto depth_float = image<float>::allocate(size, size);
+
+			int d32 = near_pixels(depth32.view(), matrix4x4f::perspective(0.1f, 10000.f, M_PIf / 3.f, 1.f), depth_test_mode::less);
+			int reversed = near_pixels(depth_float.view(), matrix4x4f::perspective_reversed(0.1f, 10000.f, M_PIf / 3.f, 1.f), depth_test_mode::greater);
+
+			EXPECT(reversed == int(size * size));
+			EXPECT(d32 < reversed);
+		}});
+
+		// Per-pixel storage is only allocated for tiles that need it, and kept across clears
+		checks.push_back({"compressed-depth-storage", []
+		{
+			auto buffer = compressed_depth_buffer::allocate(256, 256);
+			auto view = buffer.view();
+
+			std::size_t const tiles_only = buffer.memory_size();
+			EXPECT(view.at(17, 9) == 1.f);
+
+			// A third plane in the tile at (16, 8)
+			depth_plane const planes[3] = {{.c = 0.25f}, {.c = 0.5f}, {.a = 0.01f, .c = 0.125f}};
+			for (std::uint32_t i = 0; i < 3; ++i)
+				view.store(view.tile_at(16, 8), 16 + i, 8, planes[i]);
+
+			depth_tile const & tile = view.tile_at(16, 8);
+			float * const pixels = tile.pixels;
+
+			EXPECT(tile.mode == depth_tile_mode::full);
+			EXPECT(pixels != nullptr);
+			EXPECT(view.at(16, 8) == 0.25f && view.at(17, 8) == 0.5f && view.at(18, 8) == evaluate(planes[2], 18, 8) && view.at(19, 9) == 1.f);
+			EXPECT(view.tile_at(0, 0).pixels == nullptr);
+
+			std::size_t const one_tile = buffer.memory_size();
+			EXPECT(one_tile > tiles_only);
+			EXPECT(one_tile < 256 * 256 * sizeof(float));
+
+			clear(view, 0.75f);
+			EXPECT(tile.mode == depth_tile_mode::one_plane && view.at(16, 8) == 0.75f);
+
+			for (std::uint32_t i = 0; i < 3; ++i)
+				view.store(view.tile_at(16, 8), 16, 8 + i, planes[i]);
+
+			EXPECT(tile.mode == depth_tile_mode::full && tile.pixels == pixels);
+			EXPECT(view.at(16, 10) == evaluate(planes[2], 16, 10) && view.at(17, 8) == 0.75f);
+			EXPECT(buffer.memory_size() == one_tile);
+		}});
+
+		return checks;
+	}
+
+}
+
+int main(int argc, char ** argv)
+{
+	std::vector<std::string> filters(argv + 1, argv + argc);
+
+	for (auto const & check : make_checks())
+	{
+		bool selected = filters.empty();
+		for (auto const & filter : filters)
+			selected |= check.name.find(filter) != std::string::npos;
+
+		if (!selected)
+			continue;
+
+		int failures_before = failures;
+		check.run();
+		std::printf("%s %s\n", failures == failures_before ? "ok  " : "FAIL", check.name.c_str());
+	}
+
+	return failures == 0 ? 0 : 1;
+}